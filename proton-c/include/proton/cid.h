@@ -35,13 +35,16 @@ typedef enum {
   CID_pn_event,
 
   CID_pn_encoder,
+  CID_pn_writer,
   CID_pn_decoder,
+  CID_pn_reader,
   CID_pn_data,
 
   CID_pn_connection,
   CID_pn_session,
   CID_pn_link,
   CID_pn_delivery,
+  CID_pn_payload,
   CID_pn_transport,
 
   CID_pn_message,
@@ -49,6 +52,7 @@ typedef enum {
   CID_pn_io,
   CID_pn_selector,
   CID_pn_selectable,
+  CID_pn_shm,
 
   CID_pn_url
 } pn_cid_t;
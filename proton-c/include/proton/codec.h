@@ -24,6 +24,7 @@
 
 #include <proton/import_export.h>
 #include <proton/object.h>
+#include <proton/buffer.h>
 #include <proton/types.h>
 #include <proton/error.h>
 #include <proton/type_compat.h>
@@ -184,6 +185,97 @@ PN_EXTERN bool pn_data_restore(pn_data_t *data, pn_handle_t point);
 
 PN_EXTERN void pn_data_dump(pn_data_t *data);
 
+// writer
+//
+// A writer set up with pn_writer_bytes encodes into the caller's
+// buffer and fails with PN_OVERFLOW once a value no longer fits. A put,
+// begin or end that overflows writes nothing and leaves the depth as it
+// was, so pn_writer_size still covers exactly what was written before
+// it. The writer can carry on with smaller values, or the caller can
+// start again with a larger buffer. A writer set up with
+// pn_writer_buffer grows its output instead and never overflows.
+
+typedef struct pn_writer_t pn_writer_t;
+
+PN_EXTERN pn_writer_t *pn_writer(void);
+PN_EXTERN void pn_writer_free(pn_writer_t *writer);
+PN_EXTERN pn_error_t *pn_writer_error(pn_writer_t *writer);
+PN_EXTERN void pn_writer_bytes(pn_writer_t *writer, char *bytes, size_t size);
+PN_EXTERN void pn_writer_buffer(pn_writer_t *writer, pn_buffer_t *buffer);
+PN_EXTERN size_t pn_writer_size(pn_writer_t *writer);
+PN_EXTERN size_t pn_writer_depth(pn_writer_t *writer);
+
+PN_EXTERN int pn_writer_begin_list(pn_writer_t *writer);
+PN_EXTERN int pn_writer_end_list(pn_writer_t *writer);
+PN_EXTERN int pn_writer_begin_map(pn_writer_t *writer);
+PN_EXTERN int pn_writer_end_map(pn_writer_t *writer);
+PN_EXTERN int pn_writer_begin_array(pn_writer_t *writer, bool described, pn_type_t type);
+PN_EXTERN int pn_writer_end_array(pn_writer_t *writer);
+PN_EXTERN int pn_writer_put_described(pn_writer_t *writer);
+PN_EXTERN int pn_writer_put_null(pn_writer_t *writer);
+PN_EXTERN int pn_writer_put_bool(pn_writer_t *writer, bool b);
+PN_EXTERN int pn_writer_put_ubyte(pn_writer_t *writer, uint8_t ub);
+PN_EXTERN int pn_writer_put_byte(pn_writer_t *writer, int8_t b);
+PN_EXTERN int pn_writer_put_ushort(pn_writer_t *writer, uint16_t us);
+PN_EXTERN int pn_writer_put_short(pn_writer_t *writer, int16_t s);
+PN_EXTERN int pn_writer_put_uint(pn_writer_t *writer, uint32_t ui);
+PN_EXTERN int pn_writer_put_int(pn_writer_t *writer, int32_t i);
+PN_EXTERN int pn_writer_put_char(pn_writer_t *writer, pn_char_t c);
+PN_EXTERN int pn_writer_put_ulong(pn_writer_t *writer, uint64_t ul);
+PN_EXTERN int pn_writer_put_long(pn_writer_t *writer, int64_t l);
+PN_EXTERN int pn_writer_put_timestamp(pn_writer_t *writer, pn_timestamp_t t);
+PN_EXTERN int pn_writer_put_float(pn_writer_t *writer, float f);
+PN_EXTERN int pn_writer_put_double(pn_writer_t *writer, double d);
+PN_EXTERN int pn_writer_put_decimal32(pn_writer_t *writer, pn_decimal32_t d);
+PN_EXTERN int pn_writer_put_decimal64(pn_writer_t *writer, pn_decimal64_t d);
+PN_EXTERN int pn_writer_put_decimal128(pn_writer_t *writer, pn_decimal128_t d);
+PN_EXTERN int pn_writer_put_uuid(pn_writer_t *writer, pn_uuid_t u);
+PN_EXTERN int pn_writer_put_binary(pn_writer_t *writer, pn_bytes_t bytes);
+PN_EXTERN int pn_writer_put_string(pn_writer_t *writer, pn_bytes_t string);
+PN_EXTERN int pn_writer_put_symbol(pn_writer_t *writer, pn_bytes_t symbol);
+
+// reader
+
+typedef struct pn_reader_t pn_reader_t;
+
+PN_EXTERN pn_reader_t *pn_reader(void);
+PN_EXTERN void pn_reader_free(pn_reader_t *reader);
+PN_EXTERN pn_error_t *pn_reader_error(pn_reader_t *reader);
+PN_EXTERN void pn_reader_bytes(pn_reader_t *reader, const char *bytes, size_t size);
+PN_EXTERN size_t pn_reader_position(pn_reader_t *reader);
+
+PN_EXTERN bool pn_reader_next(pn_reader_t *reader);
+PN_EXTERN bool pn_reader_enter(pn_reader_t *reader);
+PN_EXTERN bool pn_reader_exit(pn_reader_t *reader);
+PN_EXTERN pn_type_t pn_reader_type(pn_reader_t *reader);
+PN_EXTERN pn_bytes_t pn_reader_encoded(pn_reader_t *reader);
+
+PN_EXTERN size_t pn_reader_get_list(pn_reader_t *reader);
+PN_EXTERN size_t pn_reader_get_map(pn_reader_t *reader);
+PN_EXTERN size_t pn_reader_get_array(pn_reader_t *reader);
+PN_EXTERN bool pn_reader_is_array_described(pn_reader_t *reader);
+PN_EXTERN pn_type_t pn_reader_get_array_type(pn_reader_t *reader);
+PN_EXTERN bool pn_reader_get_bool(pn_reader_t *reader);
+PN_EXTERN uint8_t pn_reader_get_ubyte(pn_reader_t *reader);
+PN_EXTERN int8_t pn_reader_get_byte(pn_reader_t *reader);
+PN_EXTERN uint16_t pn_reader_get_ushort(pn_reader_t *reader);
+PN_EXTERN int16_t pn_reader_get_short(pn_reader_t *reader);
+PN_EXTERN uint32_t pn_reader_get_uint(pn_reader_t *reader);
+PN_EXTERN int32_t pn_reader_get_int(pn_reader_t *reader);
+PN_EXTERN pn_char_t pn_reader_get_char(pn_reader_t *reader);
+PN_EXTERN uint64_t pn_reader_get_ulong(pn_reader_t *reader);
+PN_EXTERN int64_t pn_reader_get_long(pn_reader_t *reader);
+PN_EXTERN pn_timestamp_t pn_reader_get_timestamp(pn_reader_t *reader);
+PN_EXTERN float pn_reader_get_float(pn_reader_t *reader);
+PN_EXTERN double pn_reader_get_double(pn_reader_t *reader);
+PN_EXTERN pn_decimal32_t pn_reader_get_decimal32(pn_reader_t *reader);
+PN_EXTERN pn_decimal64_t pn_reader_get_decimal64(pn_reader_t *reader);
+PN_EXTERN pn_decimal128_t pn_reader_get_decimal128(pn_reader_t *reader);
+PN_EXTERN pn_uuid_t pn_reader_get_uuid(pn_reader_t *reader);
+PN_EXTERN pn_bytes_t pn_reader_get_binary(pn_reader_t *reader);
+PN_EXTERN pn_bytes_t pn_reader_get_string(pn_reader_t *reader);
+PN_EXTERN pn_bytes_t pn_reader_get_symbol(pn_reader_t *reader);
+
 #ifdef __cplusplus
 }
 #endif
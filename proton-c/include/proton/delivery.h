@@ -177,6 +177,69 @@ PN_EXTERN size_t pn_delivery_pending(pn_delivery_t *delivery);
  */
 PN_EXTERN bool pn_delivery_partial(pn_delivery_t *delivery);
 
+/**
+ * Construct a new ::pn_payload_t holding a copy of the given data.
+ *
+ * The payload is reference counted. Each delivery it is sent on
+ * holds its own reference, so the caller may release its reference
+ * with ::pn_payload_free as soon as it has finished sending.
+ *
+ * @param[in] bytes the start of the message data
+ * @param[in] size the number of bytes of message data
+ * @return a newly constructed payload, or NULL on failure
+ */
+PN_EXTERN pn_payload_t *pn_payload(const char *bytes, size_t size);
+
+/**
+ * Release the caller's reference to a ::pn_payload_t.
+ *
+ * The payload is freed once no delivery refers to it.
+ *
+ * @param[in] payload a payload object
+ */
+PN_EXTERN void pn_payload_free(pn_payload_t *payload);
+
+/**
+ * Get the size of the data held by a ::pn_payload_t.
+ *
+ * @param[in] payload a payload object
+ * @return the size of the payload in bytes
+ */
+PN_EXTERN size_t pn_payload_size(pn_payload_t *payload);
+
+/**
+ * Get the data held by a ::pn_payload_t.
+ *
+ * The data must not be modified.
+ *
+ * @param[in] payload a payload object
+ * @return a pointer to the start of the payload data
+ */
+PN_EXTERN const char *pn_payload_bytes(pn_payload_t *payload);
+
+/**
+ * Get the message format of a delivery.
+ *
+ * For an incoming delivery this is the format code carried by the
+ * remote transfer, zero meaning a standard AMQP message.
+ *
+ * @param[in] delivery a delivery object
+ * @return the message format code
+ */
+PN_EXTERN uint32_t pn_delivery_message_format(pn_delivery_t *delivery);
+
+/**
+ * Set the message format of an outgoing delivery.
+ *
+ * The format is sent on each transfer frame of the delivery, and so
+ * should be set before the delivery is first written. The default
+ * of zero indicates a standard AMQP message.
+ *
+ * @param[in] delivery a delivery object
+ * @param[in] format the message format code
+ */
+PN_EXTERN void pn_delivery_set_message_format(pn_delivery_t *delivery, uint32_t format);
+
 /**
  * Check if a delivery is writable.
  *
@@ -242,6 +305,20 @@ PN_EXTERN void pn_delivery_clear(pn_delivery_t *delivery);
  */
 PN_EXTERN void pn_delivery_settle(pn_delivery_t *delivery);
 
+/**
+ * Withdraw an outgoing delivery that has not started transfer.
+ *
+ * The delivery's data is discarded without being sent and the
+ * delivery is settled locally, returning any credit it would have
+ * used to the link. This fails if any of the delivery has already
+ * been written to the transport.
+ *
+ * @param[in] delivery a delivery object
+ * @return zero on success, or ::PN_STATE_ERR if the delivery is not
+ * an unsettled outgoing delivery waiting to be sent
+ */
+PN_EXTERN int pn_delivery_abort(pn_delivery_t *delivery);
+
 /**
  * Utility function for printing details of a delivery.
  *
@@ -96,6 +96,52 @@ PN_EXTERN pn_error_t *pn_driver_error(pn_driver_t *d);
  */
 PN_EXTERN void pn_driver_trace(pn_driver_t *driver, pn_trace_t trace);
 
+/** Set the spin period for the given driver.
+ *
+ * When non-zero, pn_driver_wait() polls without blocking for up to
+ * this many microseconds before blocking for the remainder of its
+ * timeout. This burns a core while idle in exchange for lower wakeup
+ * latency. The default of zero always blocks.
+ *
+ * @param[in] driver the driver
+ * @param[in] usecs the spin period in microseconds
+ */
+PN_EXTERN void pn_driver_set_spin(pn_driver_t *driver, int usecs);
+
+/** Get the spin period for the given driver.
+ *
+ * @param[in] driver the driver
+ * @return the spin period in microseconds
+ */
+PN_EXTERN int pn_driver_get_spin(pn_driver_t *driver);
+
+/** Request kernel busy polling on the driver's connections.
+ *
+ * Where supported this sets SO_BUSY_POLL to the given number of
+ * microseconds on existing and future connectors, so that the kernel
+ * polls the device queue rather than waiting for an interrupt. Values
+ * above the system default may require privileges, in which case the
+ * setting is silently ignored.
+ *
+ * @param[in] driver the driver
+ * @param[in] usecs the busy poll period in microseconds, 0 to disable
+ */
+PN_EXTERN void pn_driver_set_busy_poll(pn_driver_t *driver, int usecs);
+
+/** Get the number of waits satisfied while spinning.
+ *
+ * @param[in] driver the driver
+ * @return the number of waits that returned during the spin period
+ */
+PN_EXTERN uint64_t pn_driver_spins(pn_driver_t *driver);
+
+/** Get the number of waits that fell back to blocking.
+ *
+ * @param[in] driver the driver
+ * @return the number of waits that blocked after spinning
+ */
+PN_EXTERN uint64_t pn_driver_blocks(pn_driver_t *driver);
+
 /** Force pn_driver_wait() to return
  *
  * @param[in] driver the driver to wake up
@@ -177,6 +223,11 @@ PN_EXTERN pn_listener_t *pn_listener_next(pn_listener_t *listener);
 PN_EXTERN void pn_listener_trace(pn_listener_t *listener, pn_trace_t trace);
 
 /** Accept a connection that is pending on the listener.
+ *
+ * After a successful accept the listener is returned again by
+ * ::pn_driver_listener() so that a burst of connections can be
+ * accepted without waiting on the driver for each one. Once no
+ * connection is pending this returns NULL.
  *
  * @param[in] listener the listener to accept the connection on
  * @return a new connector for the remote, or NULL on error
@@ -46,6 +46,11 @@ extern "C" {
  *
  * pn_socket_t handles may only be used with a single pn_io_t during
  * their lifetime.
+ *
+ * On POSIX platforms a host passed to ::pn_listen() or ::pn_connect()
+ * that begins with '/' names a local (AF_UNIX) stream socket at that
+ * path, and one that begins with '@' names a socket in the Linux
+ * abstract namespace. The port is ignored for local sockets.
  */
 #if defined(_WIN32) && ! defined(__CYGWIN__)
 #ifdef _WIN64
@@ -385,6 +385,17 @@ PN_EXTERN int pn_link_credit(pn_link_t *link);
  */
 PN_EXTERN int pn_link_queued(pn_link_t *link);
 
+/**
+ * Get the number of outgoing bytes currently buffered by a link.
+ *
+ * This is the share of ::pn_session_outgoing_bytes held by the
+ * deliveries of this link.
+ *
+ * @param[in] link a link object
+ * @return the number of outgoing bytes currently buffered
+ */
+PN_EXTERN size_t pn_link_outgoing_bytes(pn_link_t *link);
+
 /**
  * Get the remote view of the credit for a link.
  *
@@ -478,6 +489,24 @@ typedef enum {
                         after the sender settles. */
 } pn_rcv_settle_mode_t;
 
+/**
+ * Describes how much of the disposition of incoming deliveries a
+ * receiving link handles by itself.
+ *
+ * See ::pn_link_set_rcv_auto_mode for more details.
+ */
+typedef enum {
+  PN_RCV_AUTO_NONE = 0, /**< The application updates and settles each
+                           delivery itself. */
+  PN_RCV_AUTO_ACCEPT = 1, /**< Each delivery is accepted as soon as it
+                             has fully arrived. */
+  PN_RCV_AUTO_SETTLE = 2, /**< Each delivery is settled as soon as it
+                             has fully arrived. */
+  PN_RCV_AUTO_ACCEPT_ON_ADVANCE = 3 /**< Each delivery is accepted and
+                                       settled when the link advances
+                                       past it. */
+} pn_rcv_auto_mode_t;
+
 /**
  * Get the local sender settle mode for a link.
  *
@@ -510,6 +539,34 @@ PN_EXTERN void pn_link_set_snd_settle_mode(pn_link_t *link, pn_snd_settle_mode_t
  */
 PN_EXTERN void pn_link_set_rcv_settle_mode(pn_link_t *link, pn_rcv_settle_mode_t mode);
 
+/**
+ * Get the receiver auto mode for a link.
+ *
+ * @param[in] link a link object
+ * @return the receiver auto mode
+ */
+PN_EXTERN pn_rcv_auto_mode_t pn_link_rcv_auto_mode(pn_link_t *link);
+
+/**
+ * Set the receiver auto mode for a link.
+ *
+ * By default (::PN_RCV_AUTO_NONE) the application must call
+ * ::pn_delivery_update, ::pn_delivery_settle and ::pn_link_advance
+ * for every delivery it consumes. The other modes let a receiving
+ * link dispose of its deliveries itself. Dispositions for
+ * ::PN_RCV_AUTO_ACCEPT and ::PN_RCV_AUTO_SETTLE are generated by the
+ * transport as deliveries arrive, and with ::PN_RCV_AUTO_SETTLE or
+ * ::PN_RCV_AUTO_ACCEPT_ON_ADVANCE each delivery is recycled as soon
+ * as ::pn_link_advance moves past it. The application must still
+ * read each delivery and advance the link.
+ *
+ * The mode has no effect on sending links.
+ *
+ * @param[in] link a link object
+ * @param[in] mode the receiver auto mode
+ */
+PN_EXTERN void pn_link_set_rcv_auto_mode(pn_link_t *link, pn_rcv_auto_mode_t mode);
+
 /**
  * Get the remote sender settle mode for a link.
  *
@@ -574,6 +631,22 @@ PN_EXTERN void pn_link_offered(pn_link_t *sender, int credit);
  */
 PN_EXTERN ssize_t pn_link_send(pn_link_t *sender, const char *bytes, size_t n);
 
+/**
+ * Send a shared payload for the current delivery on a link.
+ *
+ * The delivery holds a reference to the payload rather than copying
+ * its contents, so the same payload may be sent on many links at the
+ * cost of a reference each. The reference is released once the data
+ * has been written to the transport or the delivery is settled. If
+ * the current delivery already has message data, the payload
+ * contents are appended to it by copying instead.
+ *
+ * @param[in] sender a sender link object
+ * @param[in] payload the payload to send
+ * @return the number of bytes sent, or an error code
+ */
+PN_EXTERN ssize_t pn_link_send_payload(pn_link_t *sender, pn_payload_t *payload);
+
 //PN_EXTERN void pn_link_abort(pn_sender_t *sender);
 
 /** @} */
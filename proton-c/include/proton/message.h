@@ -64,6 +64,19 @@ typedef enum {
  */
 #define PN_DEFAULT_PRIORITY (4)
 
+/**
+ * Message format code for deliveries that carry a batch of messages
+ * written with ::pn_message_batch_encode(). The upper three octets
+ * spell "PNB" and the low octet is the batch format version.
+ */
+#define PN_MESSAGE_FORMAT_BATCH (0x504E4200)
+
+/**
+ * Capability a receiver lists on its target to indicate that it
+ * accepts ::PN_MESSAGE_FORMAT_BATCH deliveries.
+ */
+#define PN_BATCH_CAPABILITY "x-opt-proton-batch"
+
 /**
  * Construct a new ::pn_message_t.
  *
@@ -808,6 +821,39 @@ PN_EXTERN int pn_message_decode(pn_message_t *msg, const char *bytes, size_t siz
  */
 PN_EXTERN int pn_message_encode(pn_message_t *msg, char *bytes, size_t *size);
 
+/**
+ * Encode a message as one entry of a batch.
+ *
+ * A batch is the concatenation of entries, each holding one encoded
+ * message, and is sent as the content of a single delivery whose
+ * message format is set to ::PN_MESSAGE_FORMAT_BATCH with
+ * ::pn_delivery_set_message_format(). The batch is settled as a
+ * whole, so a disposition applies to every message in it. Senders
+ * should only batch when the remote target lists
+ * ::PN_BATCH_CAPABILITY.
+ *
+ * @param[in] msg a message object
+ * @param[in] bytes the start of empty buffer space
+ * @param[in] size the amount of empty buffer space
+ * @return the number of bytes written, or ::PN_OVERFLOW if the
+ * space provided is insufficient
+ */
+PN_EXTERN ssize_t pn_message_batch_encode(pn_message_t *msg, char *bytes, size_t size);
+
+/**
+ * Decode the first entry of a batch into a message.
+ *
+ * Iterate over a batch by calling this repeatedly, advancing past
+ * the bytes consumed each time, until it returns ::PN_EOS.
+ *
+ * @param[in] msg a message object
+ * @param[in] bytes the remaining batch content
+ * @param[in] size the size of the remaining batch content
+ * @return the number of bytes consumed, ::PN_EOS if no entries
+ * remain, or an error code on failure
+ */
+PN_EXTERN ssize_t pn_message_batch_decode(pn_message_t *msg, const char *bytes, size_t size);
+
 /**
  * @deprecated
  */
@@ -167,6 +167,21 @@ typedef enum {
   PN_STATUS_SETTLED = 7 /**< The remote party has settled the message. */
 } pn_status_t;
 
+/**
+ * Callback invoked when the state of an outgoing tracker changes.
+ *
+ * See ::pn_messenger_set_tracker_callback() and
+ * ::pn_messenger_put_callback().
+ *
+ * @param[in] messenger the messenger the tracker belongs to
+ * @param[in] tracker the tracker whose state changed
+ * @param[in] status the new status of the tracker
+ * @param[in] context the context supplied with the callback
+ */
+typedef void (*pn_tracker_callback_t)(pn_messenger_t *messenger,
+                                      pn_tracker_t tracker,
+                                      pn_status_t status, void *context);
+
 /**
  * Construct a new ::pn_messenger_t with the given name. The name is
  * global. If a NULL name is supplied, a UUID based name will be
@@ -395,6 +410,60 @@ PN_EXTERN int pn_messenger_get_outgoing_window(pn_messenger_t *messenger);
  */
 PN_EXTERN int pn_messenger_set_outgoing_window(pn_messenger_t *messenger, int window);
 
+/**
+ * Get the maximum number of outgoing messages a messenger will hold.
+ *
+ * Outgoing messages count against the limit from the time they are
+ * put until they have been written to the network. Once the limit is
+ * reached, pn_messenger_put waits for room in blocking mode, failing
+ * with ::PN_TIMEOUT if none frees up within the messenger's timeout,
+ * or returns ::PN_INPROGRESS in non-blocking mode without taking the
+ * message.
+ *
+ * The default limit is 0, meaning no limit.
+ *
+ * @param[in] messenger a messenger object
+ * @return the outgoing message limit for the messenger
+ */
+PN_EXTERN int pn_messenger_get_outgoing_limit(pn_messenger_t *messenger);
+
+/**
+ * Set the maximum number of outgoing messages a messenger will hold.
+ *
+ * See ::pn_messenger_get_outgoing_limit() for details.
+ *
+ * @param[in] messenger a messenger object
+ * @param[in] limit the number of messages, or 0 for no limit
+ * @return an error or zero on success
+ * @see error.h
+ */
+PN_EXTERN int pn_messenger_set_outgoing_limit(pn_messenger_t *messenger, int limit);
+
+/**
+ * Get the maximum number of encoded outgoing bytes a messenger will hold.
+ *
+ * This works like ::pn_messenger_get_outgoing_limit() but counts the
+ * encoded size of the messages rather than their number.
+ *
+ * The default limit is 0, meaning no limit.
+ *
+ * @param[in] messenger a messenger object
+ * @return the outgoing byte limit for the messenger
+ */
+PN_EXTERN size_t pn_messenger_get_outgoing_byte_limit(pn_messenger_t *messenger);
+
+/**
+ * Set the maximum number of encoded outgoing bytes a messenger will hold.
+ *
+ * See ::pn_messenger_get_outgoing_byte_limit() for details.
+ *
+ * @param[in] messenger a messenger object
+ * @param[in] limit the number of bytes, or 0 for no limit
+ * @return an error or zero on success
+ * @see error.h
+ */
+PN_EXTERN int pn_messenger_set_outgoing_byte_limit(pn_messenger_t *messenger, size_t limit);
+
 /**
  * Get the size of a messenger's incoming window.
  *
@@ -428,6 +497,59 @@ PN_EXTERN int pn_messenger_get_incoming_window(pn_messenger_t *messenger);
 PN_EXTERN int pn_messenger_set_incoming_window(pn_messenger_t *messenger,
                                                int window);
 
+/**
+ * Get the maximum number of connections a messenger will accept from
+ * a single listener each time the listener becomes readable.
+ *
+ * Accepting several connections per wakeup lets a messenger absorb a
+ * burst of incoming connections without a full I/O cycle for each
+ * one. The default accept batch is 16.
+ *
+ * @param[in] messenger a messenger object
+ * @return the accept batch for the messenger
+ */
+PN_EXTERN int pn_messenger_get_accept_batch(pn_messenger_t *messenger);
+
+/**
+ * Set the maximum number of connections a messenger will accept from
+ * a single listener each time the listener becomes readable.
+ *
+ * See ::pn_messenger_get_accept_batch() for details.
+ *
+ * @param[in] messenger a messenger object
+ * @param[in] batch the number of connections to accept, at least 1
+ * @return an error or zero on success
+ * @see error.h
+ */
+PN_EXTERN int pn_messenger_set_accept_batch(pn_messenger_t *messenger, int batch);
+
+/**
+ * Get the spin period of a messenger in microseconds.
+ *
+ * When the spin period is non-zero a messenger that would otherwise
+ * block waiting for I/O first polls without blocking for up to this
+ * long. This keeps a core busy while idle in exchange for avoiding
+ * the scheduler wakeup latency on traffic that arrives soon after the
+ * messenger goes idle. The default spin period is 0, meaning the
+ * messenger always blocks.
+ *
+ * @param[in] messenger a messenger object
+ * @return the spin period in microseconds
+ */
+PN_EXTERN int pn_messenger_get_spin(pn_messenger_t *messenger);
+
+/**
+ * Set the spin period of a messenger in microseconds.
+ *
+ * See ::pn_messenger_get_spin() for details.
+ *
+ * @param[in] messenger a messenger object
+ * @param[in] usecs the spin period in microseconds, 0 to disable
+ * @return an error or zero on success
+ * @see error.h
+ */
+PN_EXTERN int pn_messenger_set_spin(pn_messenger_t *messenger, int usecs);
+
 /**
  * Currently a no-op placeholder. For future compatibility, do not
  * send or receive messages before starting the messenger.
@@ -463,6 +585,47 @@ PN_EXTERN int pn_messenger_stop(pn_messenger_t *messenger);
  */
 PN_EXTERN bool pn_messenger_stopped(pn_messenger_t *messenger);
 
+/**
+ * Keep a connection and sender link to an address open ahead of use.
+ *
+ * The address is routed and resolved, and a connection and sender
+ * link are opened immediately rather than on the first
+ * ::pn_messenger_put() to that address, so that the name lookup,
+ * connect and AMQP handshake are not paid on the send path. Unstriped
+ * puts to exactly this address use the warm link without routing or
+ * resolving the address again. If the connection fails, or the
+ * connection or link is lost, it is reopened automatically, waiting
+ * between attempts as configured with
+ * ::pn_messenger_set_reconnect_backoff(). Warming an address that is
+ * already warm has no effect.
+ *
+ * Warm addresses are forgotten when the messenger is stopped.
+ *
+ * @param[in] messenger the messenger
+ * @param[in] address the address to keep open
+ * @return an error code or zero on success
+ * @see error.h
+ */
+PN_EXTERN int pn_messenger_warm(pn_messenger_t *messenger, const char *address);
+
+/**
+ * Set the delays used when reconnecting warm addresses.
+ *
+ * The first reconnect attempt after a connection is lost is made
+ * after the initial delay. Each failed attempt doubles the delay up to
+ * the maximum, and the delay returns to its initial value once the
+ * peer opens the connection. The defaults are 100 milliseconds and 10
+ * seconds.
+ *
+ * @param[in] messenger the messenger
+ * @param[in] initial the first reconnect delay in milliseconds
+ * @param[in] max the largest reconnect delay in milliseconds
+ * @return an error code or zero on success
+ * @see error.h
+ */
+PN_EXTERN int pn_messenger_set_reconnect_backoff(pn_messenger_t *messenger,
+                                                 int initial, int max);
+
 /**
  * Subscribes a messenger to messages from the specified source.
  *
@@ -524,6 +687,34 @@ PN_EXTERN void pn_subscription_set_context(pn_subscription_t *sub, void *context
  */
 PN_EXTERN const char *pn_subscription_address(pn_subscription_t *sub);
 
+/**
+ * Get the weight of a subscription.
+ *
+ * See ::pn_subscription_set_weight().
+ *
+ * @param[in] sub a subscription object
+ * @return the subscription's weight
+ */
+PN_EXTERN int pn_subscription_get_weight(pn_subscription_t *sub);
+
+/**
+ * Set the weight of a subscription.
+ *
+ * Messages received for each subscription are queued separately.
+ * ::pn_messenger_get() takes messages from these queues in turn,
+ * taking up to weight messages from a subscription before moving on
+ * to the next one that has messages waiting. A busy subscription
+ * therefore cannot hold back messages for the others. Messages that
+ * arrived without a subscription take their turn as if they had one
+ * of their own with weight 1. The default weight is 1.
+ *
+ * @param[in] sub a subscription object
+ * @param[in] weight the new weight, at least 1
+ * @return an error code or zero on success
+ * @see error.h
+ */
+PN_EXTERN int pn_subscription_set_weight(pn_subscription_t *sub, int weight);
+
 /**
  * Puts a message onto the messenger's outgoing queue. The message may
  * also be sent if transmission would not cause blocking. This call
@@ -536,6 +727,46 @@ PN_EXTERN const char *pn_subscription_address(pn_subscription_t *sub);
  */
 PN_EXTERN int pn_messenger_put(pn_messenger_t *messenger, pn_message_t *msg);
 
+/**
+ * Puts a message onto the messenger's outgoing queue as
+ * ::pn_messenger_put() does, and registers a callback for its
+ * tracker that takes precedence over the messenger wide callback set
+ * with ::pn_messenger_set_tracker_callback().
+ *
+ * @param[in] messenger a messenger object
+ * @param[in] msg a message to put on the messenger's outgoing queue
+ * @param[in] callback the callback for the message's tracker
+ * @param[in] context passed to the callback
+ * @return an error code or zero on success
+ * @see error.h
+ */
+PN_EXTERN int pn_messenger_put_callback(pn_messenger_t *messenger, pn_message_t *msg,
+                                        pn_tracker_callback_t callback,
+                                        void *context);
+
+/**
+ * Register a callback for changes to outgoing trackers.
+ *
+ * The callback is invoked from within the messenger's I/O processing
+ * each time the remote peer updates or settles an outgoing message,
+ * and when a message is aborted because its link was lost, so that a
+ * producer can react to outcomes without polling
+ * ::pn_messenger_status(). Only messages within the outgoing window
+ * (see ::pn_messenger_set_outgoing_window()) are reported.
+ *
+ * The callback may settle the tracker it is given but must not call
+ * messenger operations that block or perform I/O.
+ *
+ * @param[in] messenger a messenger object
+ * @param[in] callback the callback, or NULL to remove it
+ * @param[in] context passed to the callback
+ * @return an error code or zero on success
+ * @see error.h
+ */
+PN_EXTERN int pn_messenger_set_tracker_callback(pn_messenger_t *messenger,
+                                                pn_tracker_callback_t callback,
+                                                void *context);
+
 /**
  * Track the status of a delivery.
  *
@@ -719,6 +950,23 @@ PN_EXTERN int pn_messenger_receiving(pn_messenger_t *messenger);
  */
 PN_EXTERN int pn_messenger_get(pn_messenger_t *messenger, pn_message_t *message);
 
+/**
+ * Get the next message received for a particular subscription.
+ *
+ * This behaves like ::pn_messenger_get(), but only considers messages
+ * that arrived for the given subscription. Messages for other
+ * subscriptions remain queued. This operation will return ::PN_EOS
+ * if no messages for the subscription are waiting.
+ *
+ * @param[in] messenger a messenger object
+ * @param[in] sub the subscription to take a message from
+ * @param[out] message upon return contains the message, may be NULL
+ * @return an error code or zero on success
+ * @see error.h
+ */
+PN_EXTERN int pn_messenger_get_from(pn_messenger_t *messenger, pn_subscription_t *sub,
+                                    pn_message_t *message);
+
 /**
  * Get a tracker for the message most recently retrieved by
  * ::pn_messenger_get().
@@ -888,6 +1136,48 @@ PN_EXTERN int pn_messenger_incoming(pn_messenger_t *messenger);
 PN_EXTERN int pn_messenger_route(pn_messenger_t *messenger, const char *pattern,
                                  const char *address);
 
+/**
+ * Open a separate connection for each stripe, see ::pn_messenger_stripe().
+ */
+#define PN_STRIPE_CONNECTIONS (0x1)
+
+/**
+ * Keep messages that share a group id on one stripe, see
+ * ::pn_messenger_stripe().
+ */
+#define PN_STRIPE_ORDERED (0x2)
+
+/**
+ * Spread messages sent to matching addresses across several links.
+ *
+ * By default every message put to an address travels over a single
+ * sender link. A striping rule makes the messenger open the given
+ * number of sender links to the same target and hand each put to the
+ * link with the most unused credit, so that a single address is not
+ * limited to one link's worth of throughput.
+ *
+ * The links share one connection unless ::PN_STRIPE_CONNECTIONS is
+ * set, in which case each link gets its own connection. Messages are
+ * not kept in order across links. With ::PN_STRIPE_ORDERED, messages
+ * that carry a group id are always sent on the same link as other
+ * messages of that group and therefore arrive in order, while
+ * messages without a group id are still spread freely.
+ *
+ * The pattern uses the same syntax as ::pn_messenger_route() and is
+ * matched against the address of each message before routing. Rules
+ * are tried in the order they were added.
+ *
+ * @param[in] messenger a messenger object
+ * @param[in] pattern a glob pattern to select addresses
+ * @param[in] links the number of links to spread messages over
+ * @param[in] flags 0 or a combination of ::PN_STRIPE_CONNECTIONS and
+ *                  ::PN_STRIPE_ORDERED
+ * @return an error code or zero on success
+ * @see error.h
+ */
+PN_EXTERN int pn_messenger_stripe(pn_messenger_t *messenger, const char *pattern,
+                                  int links, int flags);
+
 /**
  * Rewrite message addresses prior to transmission.
  *
@@ -946,6 +1236,11 @@ PN_EXTERN pn_selectable_t *pn_messenger_selectable(pn_messenger_t *messenger);
 /**
  * Get the nearest deadline for selectables associated with a messenger.
  *
+ * Like ::pn_selectable_deadline, this is in milliseconds since the
+ * epoch. The messenger tracks its deadlines on a monotonic clock, so
+ * adjusting the wall clock moves the deadline reported here rather
+ * than when it falls due.
+ *
  * @param[in] messenger a messenger object
  * @return the nearest deadline
  */
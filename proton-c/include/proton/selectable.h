@@ -127,7 +127,8 @@ PN_EXTERN ssize_t pn_selectable_pending(pn_selectable_t *selectable);
  *
  * A selectable with a deadline is interested in being notified when
  * that deadline expires. Zero indicates there is currently no
- * deadline.
+ * deadline. Deadlines are in milliseconds since the epoch, converted
+ * from the monotonic clock they are kept on when this is called.
  *
  * @param[in] selectable a selectable object
  * @return the next deadline or zero
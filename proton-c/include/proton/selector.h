@@ -41,6 +41,11 @@ PN_EXTERN void pn_selector_update(pn_selector_t *selector, pn_selectable_t *sele
 PN_EXTERN void pn_selector_remove(pn_selector_t *selector, pn_selectable_t *selectable);
 PN_EXTERN int pn_selector_select(pn_selector_t *select, int timeout);
 PN_EXTERN pn_selectable_t *pn_selector_next(pn_selector_t *select, int *events);
+PN_EXTERN void pn_selector_set_spin(pn_selector_t *selector, int usecs);
+PN_EXTERN int pn_selector_get_spin(pn_selector_t *selector);
+PN_EXTERN void pn_selector_set_busy_poll(pn_selector_t *selector, int usecs);
+PN_EXTERN uint64_t pn_selector_spins(pn_selector_t *selector);
+PN_EXTERN uint64_t pn_selector_blocks(pn_selector_t *selector);
 
 #ifdef __cplusplus
 }
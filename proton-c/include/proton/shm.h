@@ -0,0 +1,145 @@
+#ifndef PROTON_SHM_H
+#define PROTON_SHM_H 1
+
+/*
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ *
+ */
+
+#include <proton/import_export.h>
+#include <proton/error.h>
+#include <proton/io.h>
+#include <proton/transport.h>
+#include <proton/type_compat.h>
+#include <stddef.h>
+#include <sys/types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @file
+ *
+ * Shared memory transport binding for co-located processes.
+ *
+ * @defgroup shm Shared Memory
+ * @{
+ */
+
+/**
+ * A ::pn_shm_t connects two transports through a pair of
+ * single-producer/single-consumer byte rings held in a shared memory
+ * segment, bypassing the socket layer entirely.
+ *
+ * One side creates the segment with ::pn_shm(), hands the descriptors
+ * returned by ::pn_shm_fds() to its peer (by inheritance across fork
+ * or over a unix domain socket), and the peer joins with
+ * ::pn_shm_attach(). Each side then binds a transport with
+ * ::pn_shm_bind() and calls ::pn_shm_pump() whenever its doorbell
+ * descriptor (::pn_shm_fd()) becomes readable or its transport has
+ * new output.
+ *
+ * Shared memory bindings are currently only available on Linux.
+ */
+typedef struct pn_shm_t pn_shm_t;
+
+/**
+ * Create a new shared memory segment with two rings of at least the
+ * given capacity each.
+ *
+ * @param[in] capacity the minimum capacity of each ring in bytes
+ * @return the creating side of the binding, or NULL on failure
+ */
+PN_EXTERN pn_shm_t *pn_shm(size_t capacity);
+
+/**
+ * Join a shared memory segment created by a peer.
+ *
+ * The descriptors are duplicated, so the caller remains responsible
+ * for closing the ones it passed in.
+ *
+ * @param[in] fds the three descriptors obtained from ::pn_shm_fds()
+ * @return the attaching side of the binding, or NULL on failure
+ */
+PN_EXTERN pn_shm_t *pn_shm_attach(const int fds[3]);
+
+/**
+ * Get the descriptors a peer needs to attach to this binding.
+ *
+ * @param[in] shm a shared memory binding
+ * @param[out] fds filled with the segment and the two doorbells
+ */
+PN_EXTERN void pn_shm_fds(pn_shm_t *shm, int fds[3]);
+
+/**
+ * Free a shared memory binding. The peer observes this as end of
+ * stream.
+ *
+ * @param[in] shm a shared memory binding
+ */
+PN_EXTERN void pn_shm_free(pn_shm_t *shm);
+
+/**
+ * Get the error for a shared memory binding.
+ *
+ * @param[in] shm a shared memory binding
+ * @return the binding's error object
+ */
+PN_EXTERN pn_error_t *pn_shm_error(pn_shm_t *shm);
+
+/**
+ * Bind a transport to this side of a shared memory binding.
+ *
+ * @param[in] shm a shared memory binding
+ * @param[in] transport the transport to feed and drain
+ * @return an error code, or 0 on success
+ */
+PN_EXTERN int pn_shm_bind(pn_shm_t *shm, pn_transport_t *transport);
+
+/**
+ * Get the doorbell descriptor for this side. It becomes readable when
+ * the peer has produced bytes for us or freed space we were waiting
+ * for, and may be registered with any event loop.
+ *
+ * @param[in] shm a shared memory binding
+ * @return a readable descriptor
+ */
+PN_EXTERN pn_socket_t pn_shm_fd(pn_shm_t *shm);
+
+/**
+ * Move bytes between the rings and the bound transport. Input waiting
+ * in the inbound ring is pushed into the transport, transport output
+ * is copied to the outbound ring, and the peer's doorbell is rung if
+ * anything moved.
+ *
+ * @param[in] shm a shared memory binding
+ * @return the number of bytes moved, PN_EOS once both directions
+ * have closed, or an error code
+ */
+PN_EXTERN ssize_t pn_shm_pump(pn_shm_t *shm);
+
+/** @}
+ */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* shm.h */
@@ -261,6 +261,18 @@ PN_EXTERN pn_data_t *pn_terminus_properties(pn_terminus_t *terminus);
  */
 PN_EXTERN pn_data_t *pn_terminus_capabilities(pn_terminus_t *terminus);
 
+/**
+ * Check whether a terminus lists a given capability.
+ *
+ * The capabilities may be either a single symbol or an array of
+ * symbols. The position of the capabilities data is left unchanged.
+ *
+ * @param[in] terminus a terminus object
+ * @param[in] capability the capability symbol to look for
+ * @return true if the capability is present, false otherwise
+ */
+PN_EXTERN bool pn_terminus_has_capability(pn_terminus_t *terminus, const char *capability);
+
 /**
  * Access/modify the AMQP outcomes for a terminus object.
  *
@@ -231,6 +231,17 @@ typedef struct pn_link_t pn_link_t;
  */
 typedef struct pn_delivery_t pn_delivery_t;
 
+/**
+ * An immutable, reference counted block of message data.
+ *
+ * A pn_payload_t holds an encoded message that may be sent on any
+ * number of deliveries, across links and connections, without each
+ * delivery taking its own copy. See ::pn_link_send_payload.
+ *
+ * @ingroup delivery
+ */
+typedef struct pn_payload_t pn_payload_t;
+
 /**
  * An event collector.
  *
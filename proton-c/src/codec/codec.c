@@ -80,11 +80,24 @@ static inline void pni_atom_init(pn_atom_t *atom, pn_type_t type)
 
 // data
 
+// Drops this data's hold on its storage, freeing it if no copy shares it.
+static void pni_data_release(pn_data_t *data)
+{
+  if (data->shared) {
+    bool last = --data->shared->refcount == 0;
+    if (last) free(data->shared);
+    data->shared = NULL;
+    if (!last) return;
+  }
+  free(data->nodes);
+  pn_buffer_free(data->buf);
+}
+
 static void pn_data_finalize(void *object)
 {
   pn_data_t *data = (pn_data_t *) object;
-  free(data->nodes);
-  pn_buffer_free(data->buf);
+  pni_data_release(data);
+  free(data->index);
   pn_free(data->str);
   pn_error_free(data->error);
   pn_free(data->decoder);
@@ -371,10 +384,15 @@ pn_data_t *pn_data(size_t capacity)
   data->size = 0;
   data->nodes = capacity ? (pni_node_t *) malloc(capacity * sizeof(pni_node_t)) : NULL;
   data->buf = pn_buffer(64);
+  data->shared = NULL;
   data->parent = 0;
   data->current = 0;
   data->base_parent = 0;
   data->base_current = 0;
+  data->index = NULL;
+  data->index_capacity = 0;
+  data->index_map = 0;
+  data->index_last = 0;
   data->decoder = pn_decoder();
   data->encoder = pn_encoder();
   data->error = pn_error();
@@ -406,11 +424,19 @@ void pn_data_clear(pn_data_t *data)
 {
   if (data) {
     data->size = 0;
+    data->index_map = 0;
     data->parent = 0;
     data->current = 0;
     data->base_parent = 0;
     data->base_current = 0;
-    pn_buffer_clear(data->buf);
+    if (data->shared) {
+      pni_data_release(data);
+      data->nodes = NULL;
+      data->capacity = 0;
+      data->buf = pn_buffer(64);
+    } else {
+      pn_buffer_clear(data->buf);
+    }
   }
 }
 
@@ -473,8 +499,55 @@ int pn_data_intern_node(pn_data_t *data, pni_node_t *node)
   return 0;
 }
 
+/*
+ * Gives data a private copy of its storage before it is modified. The
+ * last holder of shared storage simply takes it over.
+ */
+static void pni_data_unshare(pn_data_t *data)
+{
+  pni_data_shared_t *shared = data->shared;
+  if (!shared) return;
+
+  data->shared = NULL;
+  if (--shared->refcount == 0) {
+    free(shared);
+    return;
+  }
+
+  pni_node_t *nodes = data->nodes;
+  data->nodes = data->capacity ? (pni_node_t *) malloc(data->capacity * sizeof(pni_node_t)) : NULL;
+  if (data->size) memcpy(data->nodes, nodes, data->size * sizeof(pni_node_t));
+
+  pn_buffer_memory_t memory = pn_buffer_memory(data->buf);
+  data->buf = pn_buffer(memory.size > 64 ? memory.size : 64);
+  pn_buffer_append(data->buf, memory.start, memory.size);
+  pn_data_rebase(data, pn_buffer_memory(data->buf).start);
+}
+
+/*
+ * Makes data an O(1) copy of all of src by sharing its storage. The
+ * cursors stay independent, and whichever side mutates first takes a
+ * private copy.
+ */
+static void pni_data_share(pn_data_t *data, pn_data_t *src)
+{
+  if (!src->shared) {
+    src->shared = (pni_data_shared_t *) malloc(sizeof(pni_data_shared_t));
+    src->shared->refcount = 1;
+  }
+
+  pni_data_release(data);
+  data->nodes = src->nodes;
+  data->buf = src->buf;
+  data->capacity = src->capacity;
+  data->size = src->size;
+  data->shared = src->shared;
+  data->shared->refcount++;
+}
+
 int pn_data_vfill(pn_data_t *data, const char *fmt, va_list ap)
 {
+  const char *begin = fmt;
   int err;
   while (*fmt) {
     char code = *(fmt++);
@@ -577,7 +650,7 @@ int pn_data_vfill(pn_data_t *data, const char *fmt, va_list ap)
       }
       break;
     case '[':
-      if (*(fmt - 2) != 'T') {
+      if (fmt < begin + 2 || *(fmt - 2) != 'T') {
         err = pn_data_put_list(data);
         if (err) return err;
         pn_data_enter(data);
@@ -1106,7 +1179,9 @@ int pn_data_format(pn_data_t *data, char *bytes, size_t *size)
 int pn_data_resize(pn_data_t *data, size_t size)
 {
   if (!data || size > data->capacity) return PN_ARG_ERR;
+  pni_data_unshare(data);
   data->size = size;
+  data->index_map = 0;
   return 0;
 }
 
@@ -1122,6 +1197,8 @@ pni_node_t *pn_data_new(pn_data_t *data)
     pn_data_grow(data);
   }
   pni_node_t *node = pn_data_node(data, ++(data->size));
+  // any change to the tree invalidates the lookup index
+  data->index_map = 0;
   node->next = 0;
   node->down = 0;
   node->children = 0;
@@ -1320,23 +1397,102 @@ bool pn_data_exit(pn_data_t *data)
   }
 }
 
-bool pn_data_lookup(pn_data_t *data, const char *name)
+// maps with fewer children than this are just scanned
+#define PNI_INDEX_MIN_CHILDREN (32)
+
+static uintptr_t pni_key_hashcode(const char *start, size_t size)
 {
-  while (pn_data_next(data)) {
-    pn_type_t type = pn_data_type(data);
+  uintptr_t hashcode = 1;
+  for (size_t i = 0; i < size; i++) {
+    hashcode = hashcode * 31 + (uint8_t) start[i];
+  }
+  return hashcode;
+}
 
-    switch (type) {
-    case PN_STRING:
-    case PN_SYMBOL:
-      {
-        pn_bytes_t bytes = pn_data_get_bytes(data);
-        if (!strncmp(name, bytes.start, bytes.size)) {
-          return pn_data_next(data);
-        }
+static bool pni_key_matches(pni_node_t *node, const char *name, size_t size)
+{
+  if (node->atom.type != PN_STRING && node->atom.type != PN_SYMBOL) return false;
+  pn_bytes_t bytes = node->atom.u.as_bytes;
+  return bytes.size == size && !memcmp(bytes.start, name, size);
+}
+
+/*
+ * Builds an open addressed hash table from string and symbol keys to
+ * key nodes. Only the first occurrence of a duplicate key is kept,
+ * matching what a scan would find.
+ */
+static void pni_data_index(pn_data_t *data, pni_nid_t map)
+{
+  pni_node_t *parent = pn_data_node(data, map);
+  size_t capacity = 16;
+  while (capacity < parent->children) capacity *= 2;
+  if (capacity > data->index_capacity) {
+    data->index = (pni_nid_t *) realloc(data->index, capacity * sizeof(pni_nid_t));
+    data->index_capacity = capacity;
+  }
+  memset(data->index, 0, data->index_capacity * sizeof(pni_nid_t));
+
+  size_t mask = data->index_capacity - 1;
+  pni_nid_t last = 0;
+  for (pni_nid_t key = parent->down; key; ) {
+    pni_node_t *node = pn_data_node(data, key);
+    last = key;
+    if (node->atom.type == PN_STRING || node->atom.type == PN_SYMBOL) {
+      pn_bytes_t bytes = node->atom.u.as_bytes;
+      size_t slot = pni_key_hashcode(bytes.start, bytes.size) & mask;
+      while (data->index[slot] &&
+             !pni_key_matches(pn_data_node(data, data->index[slot]), bytes.start, bytes.size)) {
+        slot = (slot + 1) & mask;
       }
-      break;
-    default:
-      break;
+      if (!data->index[slot]) data->index[slot] = key;
+    }
+    if (node->next) {
+      last = node->next;
+      key = pn_data_node(data, node->next)->next;
+    } else {
+      key = 0;
+    }
+  }
+
+  data->index_map = map;
+  data->index_last = last;
+}
+
+static bool pni_data_lookup_indexed(pn_data_t *data, const char *name)
+{
+  if (data->index_map != data->parent) {
+    pni_data_index(data, data->parent);
+  }
+
+  size_t size = strlen(name);
+  size_t mask = data->index_capacity - 1;
+  size_t slot = pni_key_hashcode(name, size) & mask;
+  while (data->index[slot]) {
+    pni_node_t *key = pn_data_node(data, data->index[slot]);
+    if (pni_key_matches(key, name, size)) {
+      data->current = key->next ? key->next : data->index[slot];
+      return key->next != 0;
+    }
+    slot = (slot + 1) & mask;
+  }
+
+  // leave the cursor where a failed scan would
+  data->current = data->index_last;
+  return false;
+}
+
+bool pn_data_lookup(pn_data_t *data, const char *name)
+{
+  pni_node_t *parent = pn_data_node(data, data->parent);
+  if (!data->current && parent && parent->atom.type == PN_MAP &&
+      parent->children >= PNI_INDEX_MIN_CHILDREN) {
+    return pni_data_lookup_indexed(data, name);
+  }
+
+  size_t size = strlen(name);
+  while (pn_data_next(data)) {
+    if (pni_key_matches(pn_data_current(data), name, size)) {
+      return pn_data_next(data);
     }
 
     // skip the value
@@ -1367,6 +1523,7 @@ void pn_data_dump(pn_data_t *data)
 
 pni_node_t *pn_data_add(pn_data_t *data)
 {
+  pni_data_unshare(data);
   pni_node_t *current = pn_data_current(data);
   pni_node_t *parent = pn_data_node(data, data->parent);
   pni_node_t *node;
@@ -1453,6 +1610,7 @@ int pn_data_put_array(pn_data_t *data, bool described, pn_type_t type)
 
 void pni_data_set_array_type(pn_data_t *data, pn_type_t type)
 {
+  pni_data_unshare(data);
   pni_node_t *array = pn_data_current(data);
   array->type = type;
 }
@@ -1936,6 +2094,10 @@ pn_atom_t pn_data_get_atom(pn_data_t *data)
 int pn_data_copy(pn_data_t *data, pn_data_t *src)
 {
   pn_data_clear(data);
+  if (data != src && src->size && !src->base_parent && !src->base_current) {
+    pni_data_share(data, src);
+    return 0;
+  }
   int err = pn_data_append(data, src);
   pn_data_rewind(data);
   return err;
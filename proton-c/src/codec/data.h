@@ -46,9 +46,15 @@ typedef struct {
   bool small;
 } pni_node_t;
 
+// node and byte storage shared by copies until one of them mutates
+typedef struct {
+  int refcount;
+} pni_data_shared_t;
+
 struct pn_data_t {
   pni_node_t *nodes;
   pn_buffer_t *buf;
+  pni_data_shared_t *shared;
   pn_decoder_t *decoder;
   pn_encoder_t *encoder;
   pn_error_t *error;
@@ -59,6 +65,11 @@ struct pn_data_t {
   pni_nid_t current;
   pni_nid_t base_parent;
   pni_nid_t base_current;
+  // lazily built key index for the most recently searched map
+  pni_nid_t *index;
+  size_t index_capacity;
+  pni_nid_t index_map;
+  pni_nid_t index_last;
 };
 
 static inline pni_node_t * pn_data_node(pn_data_t *data, pni_nid_t nd) 
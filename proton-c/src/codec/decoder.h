@@ -26,5 +26,6 @@ typedef struct pn_decoder_t pn_decoder_t;
 
 pn_decoder_t *pn_decoder(void);
 ssize_t pn_decoder_decode(pn_decoder_t *decoder, const char *src, size_t size, pn_data_t *dst);
+pn_type_t pn_code2type(uint8_t code);
 
 #endif /* decoder.h */
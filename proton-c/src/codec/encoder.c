@@ -60,7 +60,7 @@ pn_encoder_t *pn_encoder()
   return (pn_encoder_t *) pn_class_new(&clazz, sizeof(pn_encoder_t));
 }
 
-static uint8_t pn_type2code(pn_encoder_t *encoder, pn_type_t type)
+uint8_t pni_type2code(pn_type_t type)
 {
   switch (type)
   {
@@ -89,53 +89,89 @@ static uint8_t pn_type2code(pn_encoder_t *encoder, pn_type_t type)
   case PN_ARRAY: return PNE_ARRAY32;
   case PN_MAP: return PNE_MAP32;
   case PN_DESCRIBED: return PNE_DESCRIPTOR;
-  default:
-    return pn_error_format(encoder->error, PN_ERR, "not a value type: %u\n", type);
+  default: return 0;
   }
 }
 
-static uint8_t pn_node2code(pn_encoder_t *encoder, pni_node_t *node)
+uint8_t pni_atom2code(const pn_atom_t *atom)
 {
-  switch (node->atom.type) {
+  switch (atom->type) {
   case PN_ULONG:
-    if (node->atom.u.as_ulong < 256) {
+    if (atom->u.as_ulong == 0) {
+      return PNE_ULONG0;
+    } else if (atom->u.as_ulong < 256) {
       return PNE_SMALLULONG;
     } else {
       return PNE_ULONG;
     }
   case PN_UINT:
-    if (node->atom.u.as_uint < 256) {
+    if (atom->u.as_uint == 0) {
+      return PNE_UINT0;
+    } else if (atom->u.as_uint < 256) {
       return PNE_SMALLUINT;
     } else {
       return PNE_UINT;
     }
+  case PN_LONG:
+    if (atom->u.as_long >= -128 && atom->u.as_long <= 127) {
+      return PNE_SMALLLONG;
+    } else {
+      return PNE_LONG;
+    }
+  case PN_INT:
+    if (atom->u.as_int >= -128 && atom->u.as_int <= 127) {
+      return PNE_SMALLINT;
+    } else {
+      return PNE_INT;
+    }
   case PN_BOOL:
-    if (node->atom.u.as_bool) {
+    if (atom->u.as_bool) {
       return PNE_TRUE;
     } else {
       return PNE_FALSE;
     }
   case PN_STRING:
-    if (node->atom.u.as_bytes.size < 256) {
+    if (atom->u.as_bytes.size < 256) {
       return PNE_STR8_UTF8;
     } else {
       return PNE_STR32_UTF8;
     }
   case PN_SYMBOL:
-    if (node->atom.u.as_bytes.size < 256) {
+    if (atom->u.as_bytes.size < 256) {
       return PNE_SYM8;
     } else {
       return PNE_SYM32;
     }
   case PN_BINARY:
-    if (node->atom.u.as_bytes.size < 256) {
+    if (atom->u.as_bytes.size < 256) {
       return PNE_VBIN8;
     } else {
       return PNE_VBIN32;
     }
   default:
+    return pni_type2code(atom->type);
+  }
+}
+
+static uint8_t pn_type2code(pn_encoder_t *encoder, pn_type_t type)
+{
+  uint8_t code = pni_type2code(type);
+  if (!code && type != PN_DESCRIBED) {
+    return pn_error_format(encoder->error, PN_ERR, "not a value type: %u\n", type);
+  }
+  return code;
+}
+
+static uint8_t pn_node2code(pn_encoder_t *encoder, pni_node_t *node)
+{
+  if (node->atom.type == PN_LIST && node->children == 0) {
+    return PNE_LIST0;
+  }
+  uint8_t code = pni_atom2code(&node->atom);
+  if (!code && node->atom.type != PN_DESCRIBED) {
     return pn_type2code(encoder, node->atom.type);
   }
+  return code;
 }
 
 static size_t pn_encoder_remaining(pn_encoder_t *encoder)
@@ -145,92 +181,51 @@ static size_t pn_encoder_remaining(pn_encoder_t *encoder)
 
 static inline int pn_encoder_writef8(pn_encoder_t *encoder, uint8_t value)
 {
-  if (pn_encoder_remaining(encoder)) {
-    encoder->position[0] = value;
-    encoder->position++;
-    return 0;
-  } else {
-    return PN_OVERFLOW;
-  }
+  if (pn_encoder_remaining(encoder) < 1) return PN_OVERFLOW;
+  encoder->position = pni_write8(encoder->position, value);
+  return 0;
 }
 
 static inline int pn_encoder_writef16(pn_encoder_t *encoder, uint16_t value)
 {
-  if (pn_encoder_remaining(encoder) < 2) {
-    return PN_OVERFLOW;
-  } else {
-    encoder->position[0] = 0xFF & (value >> 8);
-    encoder->position[1] = 0xFF & (value     );
-    encoder->position += 2;
-    return 0;
-  }
+  if (pn_encoder_remaining(encoder) < 2) return PN_OVERFLOW;
+  encoder->position = pni_write16(encoder->position, value);
+  return 0;
 }
 
 static inline int pn_encoder_writef32(pn_encoder_t *encoder, uint32_t value)
 {
-  if (pn_encoder_remaining(encoder) < 4) {
-    return PN_OVERFLOW;
-  } else {
-    encoder->position[0] = 0xFF & (value >> 24);
-    encoder->position[1] = 0xFF & (value >> 16);
-    encoder->position[2] = 0xFF & (value >>  8);
-    encoder->position[3] = 0xFF & (value      );
-    encoder->position += 4;
-    return 0;
-  }
+  if (pn_encoder_remaining(encoder) < 4) return PN_OVERFLOW;
+  encoder->position = pni_write32(encoder->position, value);
+  return 0;
 }
 
-static inline int pn_encoder_writef64(pn_encoder_t *encoder, uint64_t value) {
-  if (pn_encoder_remaining(encoder) < 8) {
-    return PN_OVERFLOW;
-  } else {
-    encoder->position[0] = 0xFF & (value >> 56);
-    encoder->position[1] = 0xFF & (value >> 48);
-    encoder->position[2] = 0xFF & (value >> 40);
-    encoder->position[3] = 0xFF & (value >> 32);
-    encoder->position[4] = 0xFF & (value >> 24);
-    encoder->position[5] = 0xFF & (value >> 16);
-    encoder->position[6] = 0xFF & (value >>  8);
-    encoder->position[7] = 0xFF & (value      );
-    encoder->position += 8;
-    return 0;
-  }
+static inline int pn_encoder_writef64(pn_encoder_t *encoder, uint64_t value)
+{
+  if (pn_encoder_remaining(encoder) < 8) return PN_OVERFLOW;
+  encoder->position = pni_write64(encoder->position, value);
+  return 0;
 }
 
-static inline int pn_encoder_writef128(pn_encoder_t *encoder, char *value) {
-  if (pn_encoder_remaining(encoder) < 16) {
-    return PN_OVERFLOW;
-  } else {
-    memmove(encoder->position, value, 16);
-    encoder->position += 16;
-    return 0;
-  }
+static inline int pn_encoder_writef128(pn_encoder_t *encoder, char *value)
+{
+  if (pn_encoder_remaining(encoder) < 16) return PN_OVERFLOW;
+  encoder->position = pni_write128(encoder->position, value);
+  return 0;
 }
 
 static inline int pn_encoder_writev8(pn_encoder_t *encoder, const pn_bytes_t *value)
 {
-  if (pn_encoder_remaining(encoder) < 1 + value->size) {
-    return PN_OVERFLOW;
-  } else {
-    int e = pn_encoder_writef8(encoder, value->size);
-    if (e) return e;
-    memmove(encoder->position, value->start, value->size);
-    encoder->position += value->size;
-    return 0;
-  }
+  if (pn_encoder_remaining(encoder) < 1 + value->size) return PN_OVERFLOW;
+  encoder->position = pni_writev8(encoder->position, value);
+  return 0;
 }
 
 static inline int pn_encoder_writev32(pn_encoder_t *encoder, const pn_bytes_t *value)
 {
-  if (pn_encoder_remaining(encoder) < 4 + value->size) {
-    return PN_OVERFLOW;
-  } else {
-    int e = pn_encoder_writef32(encoder, value->size);
-    if (e) return e;
-    memmove(encoder->position, value->start, value->size);
-    encoder->position += value->size;
-    return 0;
-  }
+  if (pn_encoder_remaining(encoder) < 4 + value->size) return PN_OVERFLOW;
+  encoder->position = pni_writev32(encoder->position, value);
+  return 0;
 }
 
 /* True if node is an element of an array - not the descriptor. */
@@ -294,7 +289,9 @@ static int pni_encoder_enter(void *ctx, pn_data_t *data, pni_node_t *node)
   case PNE_INT: return pn_encoder_writef32(encoder, atom->u.as_int);
   case PNE_UTF32: return pn_encoder_writef32(encoder, atom->u.as_char);
   case PNE_ULONG: return pn_encoder_writef64(encoder, atom->u.as_ulong);
+  case PNE_ULONG0: return 0;
   case PNE_SMALLULONG: return pn_encoder_writef8(encoder, atom->u.as_ulong);
+  case PNE_SMALLLONG: return pn_encoder_writef8(encoder, atom->u.as_long);
   case PNE_LONG: return pn_encoder_writef64(encoder, atom->u.as_long);
   case PNE_MS64: return pn_encoder_writef64(encoder, atom->u.as_timestamp);
   case PNE_FLOAT: c.f = atom->u.as_float; return pn_encoder_writef32(encoder, c.i);
@@ -324,6 +321,7 @@ static int pni_encoder_enter(void *ctx, pn_data_t *data, pni_node_t *node)
       if (err) return err;
     }
     return 0;
+  case PNE_LIST0: return 0;
   case PNE_LIST32:
   case PNE_MAP32:
     node->start = encoder->position;
@@ -339,9 +337,54 @@ static int pni_encoder_enter(void *ctx, pn_data_t *data, pni_node_t *node)
 
 #include <stdio.h>
 
+static uint8_t pni_compound_code8(pn_type_t type)
+{
+  switch (type) {
+  case PN_ARRAY: return PNE_ARRAY8;
+  case PN_LIST: return PNE_LIST8;
+  default: return PNE_MAP8;
+  }
+}
+
+/*
+ * Compounds are always entered with a 32 bit size and count since the
+ * encoded size isn't known until the children have been written. On
+ * exit, a compound whose size and count both fit in a byte is shrunk
+ * in place to the 8 bit form by rewriting its code and sliding its
+ * payload back over the 6 bytes saved. Elements of an array share the
+ * code written for the first element, so they keep the 32 bit form.
+ */
+char *pni_compound_backfill(char *start, char *end, pn_type_t type, size_t count,
+                            bool in_array)
+{
+  size_t size = end - start - 4;
+  if (!in_array && size - 3 <= 255 && count <= 255) {
+    start[-1] = pni_compound_code8(type);
+    start[0] = size - 3;
+    start[1] = count;
+    memmove(start + 2, start + 8, size - 4);
+    return start + 2 + (size - 4);
+  }
+
+  pni_write32(start, size);
+  pni_write32(start + 4, count);
+  return end;
+}
+
+static int pni_encoder_backfill(pn_encoder_t *encoder, pni_node_t *node, bool in_array)
+{
+  size_t count = (node->atom.type == PN_ARRAY && node->described) ?
+    node->children - 1 : node->children;
+  encoder->position = pni_compound_backfill(node->start, encoder->position,
+                                            node->atom.type, count, in_array);
+  return 0;
+}
+
 static int pni_encoder_exit(void *ctx, pn_data_t *data, pni_node_t *node)
 {
   pn_encoder_t *encoder = (pn_encoder_t *) ctx;
+  pni_node_t *parent = pn_data_node(data, node->parent);
+  bool in_array = pn_is_in_array(data, parent, node);
   char *pos;
   int err;
 
@@ -354,19 +397,19 @@ static int pni_encoder_exit(void *ctx, pn_data_t *data, pni_node_t *node)
     }
   case PN_LIST:
   case PN_MAP:
-    pos = encoder->position;
-    encoder->position = node->start;
+    if (!in_array && node->atom.type == PN_LIST && node->children == 0) {
+      // encoded as list0, nothing to backfill
+      return 0;
+    }
     if (node->small) {
       // backfill size
-      size_t size = pos - node->start - 1;
-      err = pn_encoder_writef8(encoder, size);
-    } else {
-      // backfill size
-      size_t size = pos - node->start - 4;
-      err = pn_encoder_writef32(encoder, size);
+      pos = encoder->position;
+      encoder->position = node->start;
+      err = pn_encoder_writef8(encoder, pos - node->start - 1);
+      encoder->position = pos;
+      return err;
     }
-    encoder->position = pos;
-    return err;
+    return pni_encoder_backfill(encoder, node, in_array);
   default:
     return 0;
   }
@@ -22,9 +22,75 @@
  *
  */
 
+#include <proton/codec.h>
+#include <string.h>
+
 typedef struct pn_encoder_t pn_encoder_t;
 
 pn_encoder_t *pn_encoder(void);
 ssize_t pn_encoder_encode(pn_encoder_t *encoder, pn_data_t *src, char *dst, size_t size);
 
+// Encoding helpers shared by the encoder and the writer. The stores
+// write big endian values at pos, which the caller has checked has
+// room, and return the position just past what they wrote.
+
+static inline char *pni_write8(char *pos, uint8_t value)
+{
+  pos[0] = value;
+  return pos + 1;
+}
+
+static inline char *pni_write16(char *pos, uint16_t value)
+{
+  pos[0] = 0xFF & (value >> 8);
+  pos[1] = 0xFF & (value     );
+  return pos + 2;
+}
+
+static inline char *pni_write32(char *pos, uint32_t value)
+{
+  pos[0] = 0xFF & (value >> 24);
+  pos[1] = 0xFF & (value >> 16);
+  pos[2] = 0xFF & (value >>  8);
+  pos[3] = 0xFF & (value      );
+  return pos + 4;
+}
+
+static inline char *pni_write64(char *pos, uint64_t value)
+{
+  pni_write32(pos, value >> 32);
+  return pni_write32(pos + 4, value);
+}
+
+static inline char *pni_write128(char *pos, const char *value)
+{
+  memmove(pos, value, 16);
+  return pos + 16;
+}
+
+static inline char *pni_writev8(char *pos, const pn_bytes_t *value)
+{
+  pos = pni_write8(pos, value->size);
+  memmove(pos, value->start, value->size);
+  return pos + value->size;
+}
+
+static inline char *pni_writev32(char *pos, const pn_bytes_t *value)
+{
+  pos = pni_write32(pos, value->size);
+  memmove(pos, value->start, value->size);
+  return pos + value->size;
+}
+
+// the widest code for a type, zero if it has none (note that the
+// descriptor code for PN_DESCRIBED is also zero)
+uint8_t pni_type2code(pn_type_t type);
+// the narrowest code for an atom, lists aside
+uint8_t pni_atom2code(const pn_atom_t *atom);
+// fill in the size and count of a compound entered with 32 bit ones
+// at start and ending at end, shrinking it to the 8 bit form if it
+// can; returns the new end
+char *pni_compound_backfill(char *start, char *end, pn_type_t type, size_t count,
+                            bool in_array);
+
 #endif /* encoder.h */
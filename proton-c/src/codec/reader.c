@@ -0,0 +1,553 @@
+/*
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ *
+ */
+
+#include <proton/error.h>
+#include <proton/object.h>
+#include <proton/codec.h>
+#include "encodings.h"
+#include "decoder.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+//
+// The reader is a cursor over encoded bytes. Navigation mirrors
+// pn_data_t: next moves to the following value at the current level,
+// enter descends into a list, map, array or described value, and exit
+// returns to the enclosing one. Values are never copied; moving past
+// one that wasn't entered just skips it using its size prefix, and
+// variable width values are returned as pointers into the input.
+//
+
+typedef struct {
+  const char *constructor; // start of the value, NULL if its code is shared
+  const char *payload;     // first byte after the constructor
+  const char *end;         // first byte after the value
+  uint8_t code;
+} pni_value_t;
+
+typedef struct {
+  pni_value_t value;       // the compound this frame is inside
+  const char *next;        // start of the next value
+  const char *end;         // end of the compound
+  size_t remaining;        // values left, not counting an array descriptor
+  uint8_t code;            // shared constructor of array elements
+  bool array;
+  bool descriptor;         // the next value is the array descriptor
+} pni_reader_frame_t;
+
+struct pn_reader_t {
+  pn_error_t *error;
+  const char *bytes;
+  pni_value_t current;
+  pni_reader_frame_t *frames;
+  size_t depth;
+  size_t capacity;
+};
+
+static void pn_reader_initialize(void *obj)
+{
+  pn_reader_t *reader = (pn_reader_t *) obj;
+  reader->error = pn_error();
+  reader->bytes = NULL;
+  memset(&reader->current, 0, sizeof(pni_value_t));
+  reader->capacity = 16;
+  reader->frames = (pni_reader_frame_t *) malloc(reader->capacity*sizeof(pni_reader_frame_t));
+  reader->depth = 0;
+}
+
+static void pn_reader_finalize(void *obj)
+{
+  pn_reader_t *reader = (pn_reader_t *) obj;
+  free(reader->frames);
+  pn_error_free(reader->error);
+}
+
+#define pn_reader_hashcode NULL
+#define pn_reader_compare NULL
+#define pn_reader_inspect NULL
+
+pn_reader_t *pn_reader(void)
+{
+  static const pn_class_t clazz = PN_CLASS(pn_reader);
+  return (pn_reader_t *) pn_class_new(&clazz, sizeof(pn_reader_t));
+}
+
+void pn_reader_free(pn_reader_t *reader)
+{
+  pn_free(reader);
+}
+
+pn_error_t *pn_reader_error(pn_reader_t *reader)
+{
+  return reader->error;
+}
+
+void pn_reader_bytes(pn_reader_t *reader, const char *bytes, size_t size)
+{
+  reader->bytes = bytes;
+  memset(&reader->current, 0, sizeof(pni_value_t));
+  pni_reader_frame_t *root = &reader->frames[0];
+  memset(root, 0, sizeof(pni_reader_frame_t));
+  root->next = bytes;
+  root->end = bytes + size;
+  root->remaining = (size_t) -1;
+  reader->depth = 1;
+  pn_error_clear(reader->error);
+}
+
+size_t pn_reader_position(pn_reader_t *reader)
+{
+  if (!reader->depth) return 0;
+  return reader->frames[reader->depth - 1].next - reader->bytes;
+}
+
+static inline uint8_t pni_read8(const char *p)
+{
+  return (uint8_t) p[0];
+}
+
+static inline uint16_t pni_read16(const char *p)
+{
+  return (uint16_t) ((uint8_t) p[0] << 8 | (uint8_t) p[1]);
+}
+
+static inline uint32_t pni_read32(const char *p)
+{
+  return (uint32_t) (uint8_t) p[0] << 24
+    | (uint32_t) (uint8_t) p[1] << 16
+    | (uint32_t) (uint8_t) p[2] <<  8
+    | (uint32_t) (uint8_t) p[3];
+}
+
+static inline uint64_t pni_read64(const char *p)
+{
+  return (uint64_t) pni_read32(p) << 32 | pni_read32(p + 4);
+}
+
+/*
+ * Finds the end of the value with the given code whose payload starts
+ * at p, checking that it lies within end. The value is sized from its
+ * code or size prefix, so it must not be described.
+ */
+static int pni_reader_size(pn_reader_t *reader, uint8_t code, const char *p,
+                           const char *end, const char **value_end)
+{
+  size_t size;
+
+  if ((int) pn_code2type(code) < 0) {
+    return pn_error_format(reader->error, PN_ARG_ERR, "unrecognized typecode: %u", code);
+  }
+
+  switch (code & 0xF0) {
+  case 0x40: size = 0; break;
+  case 0x50: size = 1; break;
+  case 0x60: size = 2; break;
+  case 0x70: size = 4; break;
+  case 0x80: size = 8; break;
+  case 0x90: size = 16; break;
+  case 0xA0:
+  case 0xC0:
+  case 0xE0:
+    if (end - p < 1) return pn_error_format(reader->error, PN_UNDERFLOW, "truncated size");
+    size = 1 + pni_read8(p);
+    break;
+  default:
+    if (end - p < 4) return pn_error_format(reader->error, PN_UNDERFLOW, "truncated size");
+    size = 4 + (size_t) pni_read32(p);
+    break;
+  }
+
+  if ((size_t) (end - p) < size) {
+    return pn_error_format(reader->error, PN_UNDERFLOW, "truncated value");
+  }
+  *value_end = p + size;
+  return 0;
+}
+
+/*
+ * As pni_reader_size, but also walks described values. A described
+ * value is its descriptor followed by the value, and either may be
+ * described in turn, so rather than recursing this counts the values
+ * still to be skipped. Every descriptor code consumes a byte, so the
+ * count is bounded by the input.
+ */
+static int pni_reader_skip(pn_reader_t *reader, uint8_t code, const char *p,
+                           const char *end, const char **value_end)
+{
+  size_t pending = 1;
+  while (true) {
+    if (code == PNE_DESCRIPTOR) {
+      pending++;
+    } else {
+      int err = pni_reader_size(reader, code, p, end, &p);
+      if (err) return err;
+      if (!--pending) break;
+    }
+    if (p >= end) return pn_error_format(reader->error, PN_UNDERFLOW, "truncated described value");
+    code = pni_read8(p++);
+  }
+  *value_end = p;
+  return 0;
+}
+
+bool pn_reader_next(pn_reader_t *reader)
+{
+  if (!reader->depth) return false;
+  pni_reader_frame_t *frame = &reader->frames[reader->depth - 1];
+  memset(&reader->current, 0, sizeof(pni_value_t));
+  if (!frame->remaining && !frame->descriptor) return false;
+  // once their shared constructor has been read array elements can
+  // take no bytes at all (nulls, list0 and the like), so arrays are
+  // bounded by their count alone
+  bool element = frame->array && !frame->descriptor;
+  if (!(element && frame->code) && frame->next >= frame->end) return false;
+
+  const char *p = frame->next;
+  pni_value_t value;
+  if (element) {
+    if (!frame->code) frame->code = pni_read8(p++);
+    value.constructor = NULL;
+    value.code = frame->code;
+    value.payload = p;
+  } else {
+    value.constructor = p;
+    value.code = pni_read8(p);
+    value.payload = p + 1;
+  }
+
+  if (pni_reader_skip(reader, value.code, value.payload, frame->end, &value.end)) {
+    return false;
+  }
+
+  frame->next = value.end;
+  if (frame->descriptor) {
+    frame->descriptor = false;
+  } else {
+    frame->remaining--;
+  }
+  reader->current = value;
+  return true;
+}
+
+pn_type_t pn_reader_type(pn_reader_t *reader)
+{
+  if (!reader->current.end) return (pn_type_t) -1;
+  if (reader->current.code == PNE_DESCRIPTOR) return PN_DESCRIBED;
+  return pn_code2type(reader->current.code);
+}
+
+pn_bytes_t pn_reader_encoded(pn_reader_t *reader)
+{
+  pni_value_t *value = &reader->current;
+  const char *start = value->constructor ? value->constructor : value->payload;
+  return pn_bytes(value->end - start, start);
+}
+
+/*
+ * Reads the count and the offset of the first child of a compound,
+ * returning false if its size is too small to hold them.
+ */
+static bool pni_reader_header(const pni_value_t *value, size_t *count, size_t *offset)
+{
+  switch (value->code) {
+  case PNE_LIST0:
+    *offset = 0;
+    *count = 0;
+    return true;
+  case PNE_LIST8:
+  case PNE_MAP8:
+  case PNE_ARRAY8:
+    *offset = 2;
+    if (value->end - value->payload < 2) return false;
+    *count = pni_read8(value->payload + 1);
+    return true;
+  default:
+    *offset = 8;
+    if (value->end - value->payload < 8) return false;
+    *count = pni_read32(value->payload + 4);
+    return true;
+  }
+}
+
+bool pn_reader_enter(pn_reader_t *reader)
+{
+  pni_value_t *value = &reader->current;
+  pn_type_t type = pn_reader_type(reader);
+  if (type != PN_LIST && type != PN_MAP && type != PN_ARRAY && type != PN_DESCRIBED) {
+    return false;
+  }
+
+  if (reader->depth == reader->capacity) {
+    reader->capacity *= 2;
+    reader->frames = (pni_reader_frame_t *) realloc(reader->frames, reader->capacity*sizeof(pni_reader_frame_t));
+  }
+
+  pni_reader_frame_t *frame = &reader->frames[reader->depth];
+  frame->value = *value;
+  frame->end = value->end;
+  frame->code = 0;
+  frame->array = false;
+  frame->descriptor = false;
+
+  if (type == PN_DESCRIBED) {
+    frame->next = value->payload;
+    frame->remaining = 2;
+  } else {
+    size_t count, offset;
+    if (!pni_reader_header(value, &count, &offset)) {
+      pn_error_format(reader->error, PN_UNDERFLOW, "truncated compound");
+      return false;
+    }
+    frame->next = value->payload + offset;
+    frame->remaining = count;
+    if (type == PN_ARRAY) {
+      frame->array = true;
+      if (frame->next < frame->end && pni_read8(frame->next) == PNE_DESCRIPTOR) {
+        frame->next++;
+        frame->descriptor = true;
+      }
+    }
+  }
+
+  reader->depth++;
+  memset(&reader->current, 0, sizeof(pni_value_t));
+  return true;
+}
+
+bool pn_reader_exit(pn_reader_t *reader)
+{
+  if (reader->depth <= 1) return false;
+  reader->depth--;
+  reader->current = reader->frames[reader->depth].value;
+  return true;
+}
+
+size_t pn_reader_get_list(pn_reader_t *reader)
+{
+  size_t count, offset;
+  if (pn_reader_type(reader) != PN_LIST) return 0;
+  if (!pni_reader_header(&reader->current, &count, &offset)) return 0;
+  return count;
+}
+
+size_t pn_reader_get_map(pn_reader_t *reader)
+{
+  size_t count, offset;
+  if (pn_reader_type(reader) != PN_MAP) return 0;
+  if (!pni_reader_header(&reader->current, &count, &offset)) return 0;
+  return count;
+}
+
+size_t pn_reader_get_array(pn_reader_t *reader)
+{
+  size_t count, offset;
+  if (pn_reader_type(reader) != PN_ARRAY) return 0;
+  if (!pni_reader_header(&reader->current, &count, &offset)) return 0;
+  return count;
+}
+
+static const char *pni_reader_array_constructor(pn_reader_t *reader)
+{
+  size_t count, offset;
+  if (pn_reader_type(reader) != PN_ARRAY) return NULL;
+  if (!pni_reader_header(&reader->current, &count, &offset)) return NULL;
+  const char *p = reader->current.payload + offset;
+  return p < reader->current.end ? p : NULL;
+}
+
+bool pn_reader_is_array_described(pn_reader_t *reader)
+{
+  const char *p = pni_reader_array_constructor(reader);
+  return p && pni_read8(p) == PNE_DESCRIPTOR;
+}
+
+pn_type_t pn_reader_get_array_type(pn_reader_t *reader)
+{
+  const char *p = pni_reader_array_constructor(reader);
+  const char *end = reader->current.end;
+  if (!p) return (pn_type_t) -1;
+  if (pni_read8(p) == PNE_DESCRIPTOR) {
+    p++;
+    if (p >= end || pni_reader_skip(reader, pni_read8(p), p + 1, end, &p)) {
+      return (pn_type_t) -1;
+    }
+    if (p >= end) return (pn_type_t) -1;
+  }
+  return pn_code2type(pni_read8(p));
+}
+
+bool pn_reader_get_bool(pn_reader_t *reader)
+{
+  switch (reader->current.code) {
+  case PNE_TRUE: return true;
+  case PNE_BOOLEAN: return pni_read8(reader->current.payload);
+  default: return false;
+  }
+}
+
+uint8_t pn_reader_get_ubyte(pn_reader_t *reader)
+{
+  if (reader->current.code != PNE_UBYTE) return 0;
+  return pni_read8(reader->current.payload);
+}
+
+int8_t pn_reader_get_byte(pn_reader_t *reader)
+{
+  if (reader->current.code != PNE_BYTE) return 0;
+  return (int8_t) pni_read8(reader->current.payload);
+}
+
+uint16_t pn_reader_get_ushort(pn_reader_t *reader)
+{
+  if (reader->current.code != PNE_USHORT) return 0;
+  return pni_read16(reader->current.payload);
+}
+
+int16_t pn_reader_get_short(pn_reader_t *reader)
+{
+  if (reader->current.code != PNE_SHORT) return 0;
+  return (int16_t) pni_read16(reader->current.payload);
+}
+
+uint32_t pn_reader_get_uint(pn_reader_t *reader)
+{
+  switch (reader->current.code) {
+  case PNE_SMALLUINT: return pni_read8(reader->current.payload);
+  case PNE_UINT: return pni_read32(reader->current.payload);
+  default: return 0;
+  }
+}
+
+int32_t pn_reader_get_int(pn_reader_t *reader)
+{
+  switch (reader->current.code) {
+  case PNE_SMALLINT: return (int8_t) pni_read8(reader->current.payload);
+  case PNE_INT: return (int32_t) pni_read32(reader->current.payload);
+  default: return 0;
+  }
+}
+
+pn_char_t pn_reader_get_char(pn_reader_t *reader)
+{
+  if (reader->current.code != PNE_UTF32) return 0;
+  return pni_read32(reader->current.payload);
+}
+
+uint64_t pn_reader_get_ulong(pn_reader_t *reader)
+{
+  switch (reader->current.code) {
+  case PNE_SMALLULONG: return pni_read8(reader->current.payload);
+  case PNE_ULONG: return pni_read64(reader->current.payload);
+  default: return 0;
+  }
+}
+
+int64_t pn_reader_get_long(pn_reader_t *reader)
+{
+  switch (reader->current.code) {
+  case PNE_SMALLLONG: return (int8_t) pni_read8(reader->current.payload);
+  case PNE_LONG: return (int64_t) pni_read64(reader->current.payload);
+  default: return 0;
+  }
+}
+
+pn_timestamp_t pn_reader_get_timestamp(pn_reader_t *reader)
+{
+  if (reader->current.code != PNE_MS64) return 0;
+  return (pn_timestamp_t) pni_read64(reader->current.payload);
+}
+
+float pn_reader_get_float(pn_reader_t *reader)
+{
+  // XXX: this assumes the platform uses IEEE floats
+  union { uint32_t i; float f; } conv;
+  if (reader->current.code != PNE_FLOAT) return 0;
+  conv.i = pni_read32(reader->current.payload);
+  return conv.f;
+}
+
+double pn_reader_get_double(pn_reader_t *reader)
+{
+  // XXX: this assumes the platform uses IEEE floats
+  union { uint64_t l; double d; } conv;
+  if (reader->current.code != PNE_DOUBLE) return 0;
+  conv.l = pni_read64(reader->current.payload);
+  return conv.d;
+}
+
+pn_decimal32_t pn_reader_get_decimal32(pn_reader_t *reader)
+{
+  if (reader->current.code != PNE_DECIMAL32) return 0;
+  return pni_read32(reader->current.payload);
+}
+
+pn_decimal64_t pn_reader_get_decimal64(pn_reader_t *reader)
+{
+  if (reader->current.code != PNE_DECIMAL64) return 0;
+  return pni_read64(reader->current.payload);
+}
+
+pn_decimal128_t pn_reader_get_decimal128(pn_reader_t *reader)
+{
+  pn_decimal128_t d = {{0}};
+  if (reader->current.code == PNE_DECIMAL128) {
+    memcpy(d.bytes, reader->current.payload, 16);
+  }
+  return d;
+}
+
+pn_uuid_t pn_reader_get_uuid(pn_reader_t *reader)
+{
+  pn_uuid_t u = {{0}};
+  if (reader->current.code == PNE_UUID) {
+    memcpy(u.bytes, reader->current.payload, 16);
+  }
+  return u;
+}
+
+static pn_bytes_t pni_reader_bytes(pn_reader_t *reader, uint8_t code8, uint8_t code32)
+{
+  pni_value_t *value = &reader->current;
+  if (value->code == code8) {
+    return pn_bytes(value->end - value->payload - 1, value->payload + 1);
+  } else if (value->code == code32) {
+    return pn_bytes(value->end - value->payload - 4, value->payload + 4);
+  } else {
+    pn_bytes_t t = {0};
+    return t;
+  }
+}
+
+pn_bytes_t pn_reader_get_binary(pn_reader_t *reader)
+{
+  return pni_reader_bytes(reader, PNE_VBIN8, PNE_VBIN32);
+}
+
+pn_bytes_t pn_reader_get_string(pn_reader_t *reader)
+{
+  return pni_reader_bytes(reader, PNE_STR8_UTF8, PNE_STR32_UTF8);
+}
+
+pn_bytes_t pn_reader_get_symbol(pn_reader_t *reader)
+{
+  return pni_reader_bytes(reader, PNE_SYM8, PNE_SYM32);
+}
@@ -0,0 +1,619 @@
+/*
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ *
+ */
+
+#include <proton/error.h>
+#include <proton/object.h>
+#include <proton/buffer.h>
+#include <proton/codec.h>
+#include "encodings.h"
+#include "encoder.h"
+
+#include <stdlib.h>
+
+//
+// The writer encodes straight into its output as values are put,
+// without building a pn_data_t tree first. Compounds are opened with a
+// 32 bit size and count which are backfilled when the compound is
+// ended, shrinking it to the 8 bit form in place when it fits, exactly
+// as the encoder does.
+//
+
+typedef struct {
+  pn_type_t type;    // PN_LIST, PN_MAP, PN_ARRAY or PN_DESCRIBED
+  pn_type_t element; // element type of an array
+  size_t start;      // offset of the size field
+  size_t count;      // values written so far
+  bool described;    // array has a descriptor
+  bool in_array;     // compound shares its array's constructor
+} pni_frame_t;
+
+struct pn_writer_t {
+  pn_error_t *error;
+  pn_buffer_t *buffer;
+  char *output;
+  size_t capacity;
+  size_t position;
+  size_t flushed;
+  char *scratch;
+  size_t scratch_capacity;
+  pni_frame_t *frames;
+  size_t depth;
+  size_t frames_capacity;
+};
+
+static void pn_writer_initialize(void *obj)
+{
+  pn_writer_t *writer = (pn_writer_t *) obj;
+  writer->error = pn_error();
+  writer->buffer = NULL;
+  writer->output = NULL;
+  writer->capacity = 0;
+  writer->position = 0;
+  writer->flushed = 0;
+  writer->scratch = NULL;
+  writer->scratch_capacity = 0;
+  writer->frames = NULL;
+  writer->depth = 0;
+  writer->frames_capacity = 0;
+}
+
+static void pn_writer_finalize(void *obj)
+{
+  pn_writer_t *writer = (pn_writer_t *) obj;
+  free(writer->scratch);
+  free(writer->frames);
+  pn_error_free(writer->error);
+}
+
+#define pn_writer_hashcode NULL
+#define pn_writer_compare NULL
+#define pn_writer_inspect NULL
+
+pn_writer_t *pn_writer(void)
+{
+  static const pn_class_t clazz = PN_CLASS(pn_writer);
+  return (pn_writer_t *) pn_class_new(&clazz, sizeof(pn_writer_t));
+}
+
+void pn_writer_free(pn_writer_t *writer)
+{
+  pn_free(writer);
+}
+
+pn_error_t *pn_writer_error(pn_writer_t *writer)
+{
+  return writer->error;
+}
+
+void pn_writer_bytes(pn_writer_t *writer, char *bytes, size_t size)
+{
+  writer->buffer = NULL;
+  writer->output = bytes;
+  writer->capacity = size;
+  writer->position = 0;
+  writer->flushed = 0;
+  writer->depth = 0;
+  pn_error_clear(writer->error);
+}
+
+void pn_writer_buffer(pn_writer_t *writer, pn_buffer_t *buffer)
+{
+  writer->buffer = buffer;
+  writer->output = writer->scratch;
+  writer->capacity = writer->scratch_capacity;
+  writer->position = 0;
+  writer->flushed = 0;
+  writer->depth = 0;
+  pn_error_clear(writer->error);
+}
+
+size_t pn_writer_size(pn_writer_t *writer)
+{
+  return writer->flushed + writer->position;
+}
+
+size_t pn_writer_depth(pn_writer_t *writer)
+{
+  return writer->depth;
+}
+
+static int pni_writer_ensure(pn_writer_t *writer, size_t size)
+{
+  if (writer->capacity - writer->position >= size) return 0;
+  if (!writer->buffer) return PN_OVERFLOW;
+
+  size_t capacity = writer->scratch_capacity ? 2*writer->scratch_capacity : 64;
+  while (capacity - writer->position < size) capacity *= 2;
+  writer->scratch = (char *) realloc(writer->scratch, capacity);
+  writer->scratch_capacity = capacity;
+  writer->output = writer->scratch;
+  writer->capacity = capacity;
+  return 0;
+}
+
+static inline int pni_writer_f8(pn_writer_t *writer, uint8_t value)
+{
+  int err = pni_writer_ensure(writer, 1);
+  if (err) return err;
+  pni_write8(writer->output + writer->position, value);
+  writer->position += 1;
+  return 0;
+}
+
+static inline int pni_writer_f16(pn_writer_t *writer, uint16_t value)
+{
+  int err = pni_writer_ensure(writer, 2);
+  if (err) return err;
+  pni_write16(writer->output + writer->position, value);
+  writer->position += 2;
+  return 0;
+}
+
+static inline int pni_writer_f32(pn_writer_t *writer, uint32_t value)
+{
+  int err = pni_writer_ensure(writer, 4);
+  if (err) return err;
+  pni_write32(writer->output + writer->position, value);
+  writer->position += 4;
+  return 0;
+}
+
+static inline int pni_writer_f64(pn_writer_t *writer, uint64_t value)
+{
+  int err = pni_writer_ensure(writer, 8);
+  if (err) return err;
+  pni_write64(writer->output + writer->position, value);
+  writer->position += 8;
+  return 0;
+}
+
+static inline int pni_writer_f128(pn_writer_t *writer, const char *value)
+{
+  int err = pni_writer_ensure(writer, 16);
+  if (err) return err;
+  pni_write128(writer->output + writer->position, value);
+  writer->position += 16;
+  return 0;
+}
+
+static inline int pni_writer_v8(pn_writer_t *writer, const pn_bytes_t *value)
+{
+  int err = pni_writer_ensure(writer, 1 + value->size);
+  if (err) return err;
+  pni_writev8(writer->output + writer->position, value);
+  writer->position += 1 + value->size;
+  return 0;
+}
+
+static inline int pni_writer_v32(pn_writer_t *writer, const pn_bytes_t *value)
+{
+  int err = pni_writer_ensure(writer, 4 + value->size);
+  if (err) return err;
+  pni_writev32(writer->output + writer->position, value);
+  writer->position += 4 + value->size;
+  return 0;
+}
+
+static pni_frame_t *pni_writer_top(pn_writer_t *writer)
+{
+  return writer->depth ? &writer->frames[writer->depth - 1] : NULL;
+}
+
+/* True if the next value is an element of an array - not the descriptor. */
+static bool pni_writer_in_array(pn_writer_t *writer)
+{
+  pni_frame_t *top = pni_writer_top(writer);
+  return top && top->type == PN_ARRAY && !(top->described && !top->count);
+}
+
+/*
+ * Writes the constructor for the next value. Array elements all use
+ * the wide code for the array's type, and only the first one writes it.
+ */
+static int pni_writer_constructor(pn_writer_t *writer, pn_type_t type, uint8_t *code)
+{
+  if (pni_writer_in_array(writer)) {
+    pni_frame_t *top = pni_writer_top(writer);
+    if (type != top->element) {
+      return pn_error_format(writer->error, PN_ARG_ERR, "cannot put %s in an array of %s",
+                             pn_type_name(type), pn_type_name(top->element));
+    }
+    *code = pni_type2code(type);
+    if (top->count == (top->described ? 1 : 0)) {
+      return pni_writer_f8(writer, *code);
+    }
+    return 0;
+  }
+
+  return pni_writer_f8(writer, *code);
+}
+
+static int pni_writer_complete(pn_writer_t *writer)
+{
+  while (writer->depth) {
+    pni_frame_t *top = pni_writer_top(writer);
+    top->count++;
+    if (top->type == PN_DESCRIBED && top->count == 2) {
+      // the descriptor and value together complete one value of the parent
+      writer->depth--;
+      continue;
+    }
+    return 0;
+  }
+
+  if (writer->buffer) {
+    int err = pn_buffer_append(writer->buffer, writer->output, writer->position);
+    if (err) return err;
+    writer->flushed += writer->position;
+    writer->position = 0;
+  }
+  return 0;
+}
+
+static int pni_writer_push(pn_writer_t *writer, pn_type_t type, pn_type_t element, bool described)
+{
+  if (writer->depth == writer->frames_capacity) {
+    size_t capacity = writer->frames_capacity ? 2*writer->frames_capacity : 16;
+    writer->frames = (pni_frame_t *) realloc(writer->frames, capacity*sizeof(pni_frame_t));
+    writer->frames_capacity = capacity;
+  }
+
+  bool in_array = pni_writer_in_array(writer);
+  pni_frame_t *frame = &writer->frames[writer->depth++];
+  frame->type = type;
+  frame->element = element;
+  frame->start = writer->position;
+  frame->count = 0;
+  frame->described = described;
+  frame->in_array = in_array;
+  return 0;
+}
+
+typedef union {
+  uint32_t i;
+  uint64_t l;
+  float f;
+  double d;
+} conv_t;
+
+/*
+ * A put, begin or end that runs out of room in a caller supplied
+ * buffer is undone, so the writer is left as it was before the call
+ * and the same call can be made again against a larger buffer.
+ */
+static int pni_writer_rollback(pn_writer_t *writer, size_t position, size_t depth, int err)
+{
+  writer->position = position;
+  writer->depth = depth;
+  return err;
+}
+
+static int pni_writer_put(pn_writer_t *writer, const pn_atom_t *atom)
+{
+  size_t position = writer->position;
+  uint8_t code = pni_atom2code(atom);
+  conv_t c;
+  int err = pni_writer_constructor(writer, atom->type, &code);
+  if (err) return pni_writer_rollback(writer, position, writer->depth, err);
+
+  switch (code) {
+  case PNE_NULL:
+  case PNE_TRUE:
+  case PNE_FALSE:
+  case PNE_UINT0:
+  case PNE_ULONG0: err = 0; break;
+  case PNE_BOOLEAN: err = pni_writer_f8(writer, atom->u.as_bool); break;
+  case PNE_UBYTE: err = pni_writer_f8(writer, atom->u.as_ubyte); break;
+  case PNE_BYTE: err = pni_writer_f8(writer, atom->u.as_byte); break;
+  case PNE_USHORT: err = pni_writer_f16(writer, atom->u.as_ushort); break;
+  case PNE_SHORT: err = pni_writer_f16(writer, atom->u.as_short); break;
+  case PNE_SMALLUINT: err = pni_writer_f8(writer, atom->u.as_uint); break;
+  case PNE_UINT: err = pni_writer_f32(writer, atom->u.as_uint); break;
+  case PNE_SMALLINT: err = pni_writer_f8(writer, atom->u.as_int); break;
+  case PNE_INT: err = pni_writer_f32(writer, atom->u.as_int); break;
+  case PNE_UTF32: err = pni_writer_f32(writer, atom->u.as_char); break;
+  case PNE_SMALLULONG: err = pni_writer_f8(writer, atom->u.as_ulong); break;
+  case PNE_ULONG: err = pni_writer_f64(writer, atom->u.as_ulong); break;
+  case PNE_SMALLLONG: err = pni_writer_f8(writer, atom->u.as_long); break;
+  case PNE_LONG: err = pni_writer_f64(writer, atom->u.as_long); break;
+  case PNE_MS64: err = pni_writer_f64(writer, atom->u.as_timestamp); break;
+  case PNE_FLOAT: c.f = atom->u.as_float; err = pni_writer_f32(writer, c.i); break;
+  case PNE_DOUBLE: c.d = atom->u.as_double; err = pni_writer_f64(writer, c.l); break;
+  case PNE_DECIMAL32: err = pni_writer_f32(writer, atom->u.as_decimal32); break;
+  case PNE_DECIMAL64: err = pni_writer_f64(writer, atom->u.as_decimal64); break;
+  case PNE_DECIMAL128: err = pni_writer_f128(writer, atom->u.as_decimal128.bytes); break;
+  case PNE_UUID: err = pni_writer_f128(writer, atom->u.as_uuid.bytes); break;
+  case PNE_VBIN8:
+  case PNE_STR8_UTF8:
+  case PNE_SYM8: err = pni_writer_v8(writer, &atom->u.as_bytes); break;
+  case PNE_VBIN32:
+  case PNE_STR32_UTF8:
+  case PNE_SYM32: err = pni_writer_v32(writer, &atom->u.as_bytes); break;
+  default:
+    return pn_error_format(writer->error, PN_ARG_ERR, "not a value type: %u", atom->type);
+  }
+
+  if (err) return pni_writer_rollback(writer, position, writer->depth, err);
+  return pni_writer_complete(writer);
+}
+
+static int pni_writer_begin(pn_writer_t *writer, pn_type_t type, pn_type_t element, bool described)
+{
+  size_t position = writer->position;
+  size_t depth = writer->depth;
+  uint8_t code = pni_type2code(type);
+  int err = pni_writer_constructor(writer, type, &code);
+  if (!err) err = pni_writer_push(writer, type, element, described);
+  // the size and count are backfilled when the compound is ended
+  if (!err) err = pni_writer_ensure(writer, described ? 9 : 8);
+  if (err) return pni_writer_rollback(writer, position, depth, err);
+
+  writer->position += 8;
+  if (described) {
+    pni_write8(writer->output + writer->position, PNE_DESCRIPTOR);
+    writer->position += 1;
+  }
+  return 0;
+}
+
+static int pni_writer_end(pn_writer_t *writer, pn_type_t type)
+{
+  pni_frame_t *top = pni_writer_top(writer);
+  if (!top || top->type != type) {
+    return pn_error_format(writer->error, PN_STATE_ERR, "no %s to end", pn_type_name(type));
+  }
+
+  size_t count = top->count;
+  if (type == PN_ARRAY) {
+    if (top->described && !count) {
+      return pn_error_format(writer->error, PN_STATE_ERR, "array descriptor missing");
+    }
+    if (top->described) count--;
+    if (!count) {
+      // an empty array still needs its element constructor
+      int err = pni_writer_f8(writer, pni_type2code(top->element));
+      if (err) return err;
+    }
+  }
+
+  char *start = writer->output + top->start;
+  char *end = writer->output + writer->position;
+  bool in_array = top->in_array;
+  writer->depth--;
+
+  if (!in_array && type == PN_LIST && !count) {
+    start[-1] = PNE_LIST0;
+    writer->position = top->start;
+  } else {
+    writer->position = pni_compound_backfill(start, end, type, count, in_array) - writer->output;
+  }
+
+  return pni_writer_complete(writer);
+}
+
+int pn_writer_begin_list(pn_writer_t *writer)
+{
+  return pni_writer_begin(writer, PN_LIST, PN_NULL, false);
+}
+
+int pn_writer_end_list(pn_writer_t *writer)
+{
+  return pni_writer_end(writer, PN_LIST);
+}
+
+int pn_writer_begin_map(pn_writer_t *writer)
+{
+  return pni_writer_begin(writer, PN_MAP, PN_NULL, false);
+}
+
+int pn_writer_end_map(pn_writer_t *writer)
+{
+  return pni_writer_end(writer, PN_MAP);
+}
+
+int pn_writer_begin_array(pn_writer_t *writer, bool described, pn_type_t type)
+{
+  if (!pni_type2code(type)) {
+    return pn_error_format(writer->error, PN_ARG_ERR, "not a value type: %u", type);
+  }
+  return pni_writer_begin(writer, PN_ARRAY, type, described);
+}
+
+int pn_writer_end_array(pn_writer_t *writer)
+{
+  return pni_writer_end(writer, PN_ARRAY);
+}
+
+int pn_writer_put_described(pn_writer_t *writer)
+{
+  size_t position = writer->position;
+  uint8_t code = PNE_DESCRIPTOR;
+  int err = pni_writer_constructor(writer, PN_DESCRIBED, &code);
+  if (err) return pni_writer_rollback(writer, position, writer->depth, err);
+  return pni_writer_push(writer, PN_DESCRIBED, PN_NULL, false);
+}
+
+int pn_writer_put_null(pn_writer_t *writer)
+{
+  pn_atom_t atom;
+  atom.type = PN_NULL;
+  return pni_writer_put(writer, &atom);
+}
+
+int pn_writer_put_bool(pn_writer_t *writer, bool b)
+{
+  pn_atom_t atom;
+  atom.type = PN_BOOL;
+  atom.u.as_bool = b;
+  return pni_writer_put(writer, &atom);
+}
+
+int pn_writer_put_ubyte(pn_writer_t *writer, uint8_t ub)
+{
+  pn_atom_t atom;
+  atom.type = PN_UBYTE;
+  atom.u.as_ubyte = ub;
+  return pni_writer_put(writer, &atom);
+}
+
+int pn_writer_put_byte(pn_writer_t *writer, int8_t b)
+{
+  pn_atom_t atom;
+  atom.type = PN_BYTE;
+  atom.u.as_byte = b;
+  return pni_writer_put(writer, &atom);
+}
+
+int pn_writer_put_ushort(pn_writer_t *writer, uint16_t us)
+{
+  pn_atom_t atom;
+  atom.type = PN_USHORT;
+  atom.u.as_ushort = us;
+  return pni_writer_put(writer, &atom);
+}
+
+int pn_writer_put_short(pn_writer_t *writer, int16_t s)
+{
+  pn_atom_t atom;
+  atom.type = PN_SHORT;
+  atom.u.as_short = s;
+  return pni_writer_put(writer, &atom);
+}
+
+int pn_writer_put_uint(pn_writer_t *writer, uint32_t ui)
+{
+  pn_atom_t atom;
+  atom.type = PN_UINT;
+  atom.u.as_uint = ui;
+  return pni_writer_put(writer, &atom);
+}
+
+int pn_writer_put_int(pn_writer_t *writer, int32_t i)
+{
+  pn_atom_t atom;
+  atom.type = PN_INT;
+  atom.u.as_int = i;
+  return pni_writer_put(writer, &atom);
+}
+
+int pn_writer_put_char(pn_writer_t *writer, pn_char_t c)
+{
+  pn_atom_t atom;
+  atom.type = PN_CHAR;
+  atom.u.as_char = c;
+  return pni_writer_put(writer, &atom);
+}
+
+int pn_writer_put_ulong(pn_writer_t *writer, uint64_t ul)
+{
+  pn_atom_t atom;
+  atom.type = PN_ULONG;
+  atom.u.as_ulong = ul;
+  return pni_writer_put(writer, &atom);
+}
+
+int pn_writer_put_long(pn_writer_t *writer, int64_t l)
+{
+  pn_atom_t atom;
+  atom.type = PN_LONG;
+  atom.u.as_long = l;
+  return pni_writer_put(writer, &atom);
+}
+
+int pn_writer_put_timestamp(pn_writer_t *writer, pn_timestamp_t t)
+{
+  pn_atom_t atom;
+  atom.type = PN_TIMESTAMP;
+  atom.u.as_timestamp = t;
+  return pni_writer_put(writer, &atom);
+}
+
+int pn_writer_put_float(pn_writer_t *writer, float f)
+{
+  pn_atom_t atom;
+  atom.type = PN_FLOAT;
+  atom.u.as_float = f;
+  return pni_writer_put(writer, &atom);
+}
+
+int pn_writer_put_double(pn_writer_t *writer, double d)
+{
+  pn_atom_t atom;
+  atom.type = PN_DOUBLE;
+  atom.u.as_double = d;
+  return pni_writer_put(writer, &atom);
+}
+
+int pn_writer_put_decimal32(pn_writer_t *writer, pn_decimal32_t d)
+{
+  pn_atom_t atom;
+  atom.type = PN_DECIMAL32;
+  atom.u.as_decimal32 = d;
+  return pni_writer_put(writer, &atom);
+}
+
+int pn_writer_put_decimal64(pn_writer_t *writer, pn_decimal64_t d)
+{
+  pn_atom_t atom;
+  atom.type = PN_DECIMAL64;
+  atom.u.as_decimal64 = d;
+  return pni_writer_put(writer, &atom);
+}
+
+int pn_writer_put_decimal128(pn_writer_t *writer, pn_decimal128_t d)
+{
+  pn_atom_t atom;
+  atom.type = PN_DECIMAL128;
+  atom.u.as_decimal128 = d;
+  return pni_writer_put(writer, &atom);
+}
+
+int pn_writer_put_uuid(pn_writer_t *writer, pn_uuid_t u)
+{
+  pn_atom_t atom;
+  atom.type = PN_UUID;
+  atom.u.as_uuid = u;
+  return pni_writer_put(writer, &atom);
+}
+
+int pn_writer_put_binary(pn_writer_t *writer, pn_bytes_t bytes)
+{
+  pn_atom_t atom;
+  atom.type = PN_BINARY;
+  atom.u.as_bytes = bytes;
+  return pni_writer_put(writer, &atom);
+}
+
+int pn_writer_put_string(pn_writer_t *writer, pn_bytes_t string)
+{
+  pn_atom_t atom;
+  atom.type = PN_STRING;
+  atom.u.as_bytes = string;
+  return pni_writer_put(writer, &atom);
+}
+
+int pn_writer_put_symbol(pn_writer_t *writer, pn_bytes_t symbol)
+{
+  pn_atom_t atom;
+  atom.type = PN_SYMBOL;
+  atom.u.as_bytes = symbol;
+  return pni_writer_put(writer, &atom);
+}
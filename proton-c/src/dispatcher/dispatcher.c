@@ -32,6 +32,8 @@
 
 #include "dispatch_actions.h"
 
+#define PN_DISPATCHER_INITIAL_CAPACITY (4*1024)
+
 int pni_bad_frame(pn_dispatcher_t* disp) {
   pn_transport_log(disp->transport, "Error dispatching frame: Unknown performative");
   return PN_ERR;
@@ -83,7 +85,7 @@ pn_dispatcher_t *pn_dispatcher(uint8_t frame_type, pn_transport_t *transport)
   disp->output_args = pn_data(16);
   disp->frame = pn_buffer( 4*1024 );
   // XXX
-  disp->capacity = 4*1024;
+  disp->capacity = PN_DISPATCHER_INITIAL_CAPACITY;
   disp->output = (char *) malloc(disp->capacity);
   disp->available = 0;
 
@@ -269,6 +271,7 @@ int pn_post_frame(pn_dispatcher_t *disp, uint16_t ch, const char *fmt, ...)
     pn_transport_log(disp->transport, pn_string_get(disp->scratch));
   }
   disp->available += n;
+  pni_usage_fill(&disp->output_usage, disp->available);
 
   return 0;
 }
@@ -279,10 +282,39 @@ ssize_t pn_dispatcher_output(pn_dispatcher_t *disp, char *bytes, size_t size)
   memmove(bytes, disp->output, n);
   memmove(disp->output, disp->output + n, disp->available - n);
   disp->available -= n;
+  if (!disp->available) {
+    // give back space a burst of large frames left behind
+    size_t capacity = pni_usage_drained(&disp->output_usage, disp->capacity,
+                                        PN_DISPATCHER_INITIAL_CAPACITY);
+    if (capacity < disp->capacity) {
+      char *output = (char *) realloc(disp->output, capacity);
+      if (output) {
+        disp->output = output;
+        disp->capacity = capacity;
+      }
+    }
+  }
   // XXX: need to check for errors
   return n;
 }
 
+// give back output space a burst left behind once the connection has
+// gone quiet, returns when to look again
+pn_timestamp_t pn_dispatcher_tick(pn_dispatcher_t *disp, pn_timestamp_t now)
+{
+  if (disp->available) pni_usage_fill(&disp->output_usage, disp->available);
+  size_t capacity = pni_usage_idle(&disp->output_usage, disp->capacity,
+                                   PN_DISPATCHER_INITIAL_CAPACITY, now);
+  if (capacity < disp->capacity) {
+    char *output = (char *) realloc(disp->output, capacity);
+    if (output) {
+      disp->output = output;
+      disp->capacity = capacity;
+    }
+  }
+  return pni_usage_deadline(&disp->output_usage);
+}
+
 
 int pn_post_transfer_frame(pn_dispatcher_t *disp, uint16_t ch,
                            uint32_t handle,
@@ -378,6 +410,7 @@ int pn_post_transfer_frame(pn_dispatcher_t *disp, uint16_t ch,
       pn_transport_log(disp->transport, pn_string_get(disp->scratch));
     }
     disp->available += n;
+    pni_usage_fill(&disp->output_usage, disp->available);
   } while (disp->output_size > 0 && framecount < frame_limit);
 
   disp->output_payload = NULL;
@@ -29,6 +29,7 @@
 #include "proton/buffer.h"
 #include "proton/codec.h"
 #include "proton/transport.h"
+#include "util.h"
 
 typedef struct pn_dispatcher_t pn_dispatcher_t;
 
@@ -46,6 +47,7 @@ struct pn_dispatcher_t {
   size_t capacity;
   size_t available; /* number of raw bytes pending output */
   char *output;
+  pni_usage_t output_usage;
   pn_transport_t *transport; // TODO: We keep this to get access to logging - perhaps move logging
   uint64_t output_frames_ct;
   uint64_t input_frames_ct;
@@ -64,6 +66,7 @@ void pn_set_payload(pn_dispatcher_t *disp, const char *data, size_t size);
 int pn_post_frame(pn_dispatcher_t *disp, uint16_t ch, const char *fmt, ...);
 ssize_t pn_dispatcher_input(pn_dispatcher_t *disp, const char *bytes, size_t available);
 ssize_t pn_dispatcher_output(pn_dispatcher_t *disp, char *bytes, size_t size);
+pn_timestamp_t pn_dispatcher_tick(pn_dispatcher_t *disp, pn_timestamp_t now);
 int pn_post_transfer_frame(pn_dispatcher_t *disp,
                            uint16_t local_channel,
                            uint32_t handle,
@@ -158,6 +158,7 @@ struct pn_transport_t {
   size_t output_size;
   size_t output_pending;
   char *output_buf;
+  pni_usage_t output_usage;
 
   void *context;
 
@@ -165,6 +166,7 @@ struct pn_transport_t {
   size_t input_size;
   size_t input_pending;
   char *input_buf;
+  pni_usage_t input_usage;
 
   uint16_t channel_max;
   uint16_t remote_channel_max;
@@ -246,11 +248,13 @@ struct pn_link_t {
   pn_sequence_t available;
   pn_sequence_t credit;
   pn_sequence_t queued;
+  size_t outgoing_bytes;
   int drained; // number of drained credits
   uint8_t snd_settle_mode;
   uint8_t rcv_settle_mode;
   uint8_t remote_snd_settle_mode;
   uint8_t remote_rcv_settle_mode;
+  uint8_t rcv_auto_mode;
   bool drain_flag_mode; // receiver only
   bool drain;
   bool detached;
@@ -268,6 +272,11 @@ struct pn_disposition_t {
   bool settled;
 };
 
+struct pn_payload_t {
+  char *bytes;
+  size_t size;
+};
+
 struct pn_delivery_t {
   pn_disposition_t local;
   pn_disposition_t remote;
@@ -283,7 +292,10 @@ struct pn_delivery_t {
   pn_delivery_t *tpwork_prev;
   pn_delivery_state_t state;
   pn_buffer_t *bytes;
+  pn_payload_t *payload;
+  size_t payload_offset;
   void *context;
+  uint32_t format;
   bool updated;
   bool settled; // tracks whether we're in the unsettled list or not
   bool work;
@@ -298,6 +310,9 @@ struct pn_delivery_t {
   (OLD) = ((OLD) & PN_LOCAL_MASK) | (NEW)
 
 void pn_link_dump(pn_link_t *link);
+void pni_delivery_release_payload(pn_delivery_t *delivery);
+pn_bytes_t pni_delivery_bytes(pn_delivery_t *delivery);
+void pni_delivery_consume(pn_delivery_t *delivery, size_t size);
 
 void pn_dump(pn_connection_t *conn);
 void pn_transport_sasl_init(pn_transport_t *transport);
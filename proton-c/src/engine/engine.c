@@ -859,6 +859,7 @@ pn_link_t *pn_link_new(int type, pn_session_t *session, const char *name)
   link->available = 0;
   link->credit = 0;
   link->queued = 0;
+  link->outgoing_bytes = 0;
   link->drain = false;
   link->drain_flag_mode = true;
   link->drained = 0;
@@ -867,6 +868,7 @@ pn_link_t *pn_link_new(int type, pn_session_t *session, const char *name)
   link->rcv_settle_mode = PN_RCV_FIRST;
   link->remote_snd_settle_mode = PN_SND_MIXED;
   link->remote_rcv_settle_mode = PN_RCV_FIRST;
+  link->rcv_auto_mode = PN_RCV_AUTO_NONE;
   link->detached = false;
 
   // begin transport state
@@ -991,6 +993,31 @@ pn_data_t *pn_terminus_capabilities(pn_terminus_t *terminus)
   return terminus ? terminus->capabilities : NULL;
 }
 
+bool pn_terminus_has_capability(pn_terminus_t *terminus, const char *capability)
+{
+  if (!terminus || !capability) return false;
+
+  pn_data_t *caps = terminus->capabilities;
+  size_t len = strlen(capability);
+  bool found = false;
+  pn_handle_t point = pn_data_point(caps);
+  pn_data_rewind(caps);
+  if (pn_data_next(caps)) {
+    // a lone symbol is permitted in place of a single element array
+    bool array = pn_data_type(caps) == PN_ARRAY;
+    if (array) pn_data_enter(caps);
+    while (!found && (!array || pn_data_next(caps))) {
+      if (pn_data_type(caps) == PN_SYMBOL) {
+        pn_bytes_t sym = pn_data_get_symbol(caps);
+        found = sym.size == len && !memcmp(sym.start, capability, len);
+      }
+      if (!array) break;
+    }
+  }
+  pn_data_restore(caps, point);
+  return found;
+}
+
 pn_data_t *pn_terminus_outcomes(pn_terminus_t *terminus)
 {
   return terminus ? terminus->outcomes : NULL;
@@ -1094,6 +1121,7 @@ static void pn_delivery_finalize(void *object)
   assert(!delivery->state.init);  // no longer in session delivery map
   pn_buffer_free(delivery->tag);
   pn_buffer_free(delivery->bytes);
+  pn_decref(delivery->payload);
   pn_disposition_finalize(&delivery->local);
   pn_disposition_finalize(&delivery->remote);
   pn_decref(delivery->link);
@@ -1124,6 +1152,72 @@ static void pn_disposition_clear(pn_disposition_t *ds)
 #define pn_delivery_compare NULL
 #define pn_delivery_inspect NULL
 
+#define pn_payload_finalize NULL
+#define pn_payload_hashcode NULL
+#define pn_payload_compare NULL
+#define pn_payload_inspect NULL
+#define pn_payload_initialize NULL
+
+pn_payload_t *pn_payload(const char *bytes, size_t size)
+{
+  static const pn_class_t clazz = PN_CLASS(pn_payload);
+  // the data lives in the same allocation, just past the header
+  pn_payload_t *payload = (pn_payload_t *) pn_class_new(&clazz, sizeof(pn_payload_t) + size);
+  if (!payload) return NULL;
+  payload->bytes = (char *) (payload + 1);
+  payload->size = size;
+  if (size) memcpy(payload->bytes, bytes, size);
+  return payload;
+}
+
+void pn_payload_free(pn_payload_t *payload)
+{
+  pn_decref(payload);
+}
+
+size_t pn_payload_size(pn_payload_t *payload)
+{
+  assert(payload);
+  return payload->size;
+}
+
+const char *pn_payload_bytes(pn_payload_t *payload)
+{
+  assert(payload);
+  return payload->bytes;
+}
+
+void pni_delivery_release_payload(pn_delivery_t *delivery)
+{
+  if (delivery->payload) {
+    pn_decref(delivery->payload);
+    delivery->payload = NULL;
+    delivery->payload_offset = 0;
+  }
+}
+
+pn_bytes_t pni_delivery_bytes(pn_delivery_t *delivery)
+{
+  if (delivery->payload) {
+    return pn_bytes(delivery->payload->size - delivery->payload_offset,
+                    delivery->payload->bytes + delivery->payload_offset);
+  } else {
+    return pn_buffer_bytes(delivery->bytes);
+  }
+}
+
+void pni_delivery_consume(pn_delivery_t *delivery, size_t size)
+{
+  if (delivery->payload) {
+    delivery->payload_offset += size;
+    if (delivery->payload_offset == delivery->payload->size) {
+      pni_delivery_release_payload(delivery);
+    }
+  } else {
+    pn_buffer_trim(delivery->bytes, size, 0);
+  }
+}
+
 pn_delivery_t *pn_delivery(pn_link_t *link, pn_delivery_tag_t tag)
 {
   assert(link);
@@ -1137,6 +1231,7 @@ pn_delivery_t *pn_delivery(pn_link_t *link, pn_delivery_tag_t tag)
     pn_incref(delivery->link);  // keep link until finalized
     delivery->tag = pn_buffer(16);
     delivery->bytes = pn_buffer(64);
+    delivery->payload = NULL;
     pn_disposition_init(&delivery->local);
     pn_disposition_init(&delivery->remote);
   } else {
@@ -1156,7 +1251,9 @@ pn_delivery_t *pn_delivery(pn_link_t *link, pn_delivery_tag_t tag)
   delivery->tpwork_prev = NULL;
   delivery->tpwork = false;
   pn_buffer_clear(delivery->bytes);
+  pni_delivery_release_payload(delivery);
   delivery->done = false;
+  delivery->format = 0;
   delivery->context = NULL;
 
   // begin delivery state
@@ -1183,7 +1280,7 @@ bool pn_delivery_buffered(pn_delivery_t *delivery)
     if (state->sent) {
       return false;
     } else {
-      return delivery->done || (pn_buffer_size(delivery->bytes) > 0);
+      return delivery->done || (pn_delivery_pending(delivery) > 0);
     }
   } else {
     return false;
@@ -1352,7 +1449,14 @@ void pn_advance_receiver(pn_link_t *link)
   link->session->incoming_bytes -= pn_buffer_size(current->bytes);
   pn_buffer_clear(current->bytes);
 
-  if (!link->session->state.incoming_window) {
+  if (link->rcv_auto_mode == PN_RCV_AUTO_ACCEPT_ON_ADVANCE && !current->local.settled) {
+    current->local.type = PN_ACCEPTED;
+    current->local.settled = true;
+    link->unsettled_count--;
+  }
+
+  // a delivery settled before it was read is recycled once read
+  if (!link->session->state.incoming_window || current->local.settled) {
     pn_add_tpwork(current);
   }
 
@@ -1392,6 +1496,11 @@ int pn_link_queued(pn_link_t *link)
   return link ? link->queued : 0;
 }
 
+size_t pn_link_outgoing_bytes(pn_link_t *link)
+{
+  return link ? link->outgoing_bytes : 0;
+}
+
 int pn_link_remote_credit(pn_link_t *link)
 {
   assert(link);
@@ -1438,6 +1547,18 @@ void pn_link_set_rcv_settle_mode(pn_link_t *link, pn_rcv_settle_mode_t mode)
     link->rcv_settle_mode = (uint8_t)mode;
 }
 
+pn_rcv_auto_mode_t pn_link_rcv_auto_mode(pn_link_t *link)
+{
+  return link ? (pn_rcv_auto_mode_t)link->rcv_auto_mode
+      : PN_RCV_AUTO_NONE;
+}
+
+void pn_link_set_rcv_auto_mode(pn_link_t *link, pn_rcv_auto_mode_t mode)
+{
+  if (link)
+    link->rcv_auto_mode = (uint8_t)mode;
+}
+
 void pn_real_settle(pn_delivery_t *delivery)
 {
   pn_link_t *link = delivery->link;
@@ -1448,6 +1569,7 @@ void pn_real_settle(pn_delivery_t *delivery)
                       delivery);
   pn_buffer_clear(delivery->tag);
   pn_buffer_clear(delivery->bytes);
+  pni_delivery_release_payload(delivery);
   delivery->settled = true;
   if (link->endpoint.freed) {
     pn_decref(delivery);
@@ -1472,6 +1594,33 @@ void pn_delivery_settle(pn_delivery_t *delivery)
   }
 }
 
+int pn_delivery_abort(pn_delivery_t *delivery)
+{
+  assert(delivery);
+  pn_link_t *link = delivery->link;
+  if (!pn_link_is_sender(link) || delivery->local.settled || delivery->state.init) {
+    return PN_STATE_ERR;
+  }
+
+  // undo whatever pn_advance_sender accounted for
+  if (pn_is_current(delivery)) {
+    link->current = delivery->unsettled_next;
+  } else {
+    link->queued--;
+    link->credit++;
+    link->session->outgoing_deliveries--;
+  }
+  link->session->outgoing_bytes -= pn_delivery_pending(delivery);
+  link->outgoing_bytes -= pn_delivery_pending(delivery);
+  link->unsettled_count--;
+  delivery->local.settled = true;
+  delivery->done = true;
+  pn_clear_work(link->session->connection, delivery);
+  pn_clear_tpwork(delivery);
+  pn_real_settle(delivery);
+  return 0;
+}
+
 void pn_link_offered(pn_link_t *sender, int credit)
 {
   sender->available = credit;
@@ -1482,12 +1631,36 @@ ssize_t pn_link_send(pn_link_t *sender, const char *bytes, size_t n)
   pn_delivery_t *current = pn_link_current(sender);
   if (!current) return PN_EOS;
   if (!bytes || !n) return 0;
+  if (current->payload) {
+    // keep ordering by moving the unsent part of the payload into the buffer
+    pn_bytes_t unsent = pni_delivery_bytes(current);
+    pn_buffer_append(current->bytes, unsent.start, unsent.size);
+    pni_delivery_release_payload(current);
+  }
   pn_buffer_append(current->bytes, bytes, n);
   sender->session->outgoing_bytes += n;
+  sender->outgoing_bytes += n;
   pn_add_tpwork(current);
   return n;
 }
 
+ssize_t pn_link_send_payload(pn_link_t *sender, pn_payload_t *payload)
+{
+  pn_delivery_t *current = pn_link_current(sender);
+  if (!current) return PN_EOS;
+  if (!payload || !payload->size) return 0;
+  if (current->payload || pn_buffer_size(current->bytes)) {
+    return pn_link_send(sender, payload->bytes, payload->size);
+  }
+  pn_incref(payload);
+  current->payload = payload;
+  current->payload_offset = 0;
+  sender->session->outgoing_bytes += payload->size;
+  sender->outgoing_bytes += payload->size;
+  pn_add_tpwork(current);
+  return payload->size;
+}
+
 int pn_link_drained(pn_link_t *link)
 {
   assert(link);
@@ -1640,6 +1813,9 @@ bool pn_delivery_readable(pn_delivery_t *delivery)
 
 size_t pn_delivery_pending(pn_delivery_t *delivery)
 {
+  if (delivery->payload) {
+    return delivery->payload->size - delivery->payload_offset;
+  }
   return pn_buffer_size(delivery->bytes);
 }
 
@@ -1648,6 +1824,18 @@ bool pn_delivery_partial(pn_delivery_t *delivery)
   return !delivery->done;
 }
 
+uint32_t pn_delivery_message_format(pn_delivery_t *delivery)
+{
+  assert(delivery);
+  return delivery->format;
+}
+
+void pn_delivery_set_message_format(pn_delivery_t *delivery, uint32_t format)
+{
+  assert(delivery);
+  delivery->format = format;
+}
+
 pn_condition_t *pn_connection_condition(pn_connection_t *connection)
 {
   assert(connection);
@@ -29,6 +29,7 @@
 #include <stdio.h>
 #include <assert.h>
 #include "protocol.h"
+#include "encodings.h"
 #include "util.h"
 #include "platform_fmt.h"
 
@@ -865,6 +866,56 @@ int pn_message_encode(pn_message_t *msg, char *bytes, size_t *size)
   return 0;
 }
 
+ssize_t pn_message_batch_encode(pn_message_t *msg, char *bytes, size_t size)
+{
+  // encode behind room for a vbin32 header, then slide back if vbin8 fits
+  if (size < 5) return PN_OVERFLOW;
+  size_t n = size - 5;
+  int err = pn_message_encode(msg, bytes + 5, &n);
+  if (err) return err;
+
+  if (n < 256) {
+    bytes[0] = (char) PNE_VBIN8;
+    bytes[1] = n;
+    memmove(bytes + 2, bytes + 5, n);
+    return n + 2;
+  } else {
+    bytes[0] = (char) PNE_VBIN32;
+    bytes[1] = 0xFF & (n >> 24);
+    bytes[2] = 0xFF & (n >> 16);
+    bytes[3] = 0xFF & (n >>  8);
+    bytes[4] = 0xFF & (n      );
+    return n + 5;
+  }
+}
+
+ssize_t pn_message_batch_decode(pn_message_t *msg, const char *bytes, size_t size)
+{
+  if (!size) return PN_EOS;
+
+  size_t header, n;
+  switch ((uint8_t) bytes[0]) {
+  case PNE_VBIN8:
+    header = 2;
+    if (size < header) return PN_UNDERFLOW;
+    n = (uint8_t) bytes[1];
+    break;
+  case PNE_VBIN32:
+    header = 5;
+    if (size < header) return PN_UNDERFLOW;
+    n = (size_t) (uint8_t) bytes[1] << 24 | (size_t) (uint8_t) bytes[2] << 16 |
+      (size_t) (uint8_t) bytes[3] << 8 | (uint8_t) bytes[4];
+    break;
+  default:
+    return pn_error_format(msg->error, PN_ARG_ERR, "not a batch entry: %u", (uint8_t) bytes[0]);
+  }
+
+  if (size - header < n) return PN_UNDERFLOW;
+  int err = pn_message_decode(msg, bytes + header, n);
+  if (err) return err;
+  return header + n;
+}
+
 pn_format_t pn_message_get_format(pn_message_t *msg)
 {
   return msg ? msg->format : PN_AMQP;
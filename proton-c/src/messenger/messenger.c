@@ -73,6 +73,7 @@ struct pn_messenger_t {
   char *trusted_certificates;
   pn_io_t *io;
   pn_list_t *pending; // pending selectables
+  pn_list_t *writable; // selectables to write once events are processed
   pn_selectable_t *interruptor;
   pn_socket_t ctrl[2];
   pn_list_t *listeners;
@@ -81,12 +82,19 @@ struct pn_messenger_t {
   pn_collector_t *collector;
   pn_list_t *credited;
   pn_list_t *blocked;
+  pn_timestamp_t now;  // monotonic clock, read once per pass of pn_messenger_process
+  pn_timestamp_t epoch;  // wall clock at which now read zero, for public deadlines
   pn_timestamp_t next_drain;
+  pn_timestamp_t next_expiry;  // earliest expiry of a message held by a link
   uint64_t next_tag;
   pni_store_t *outgoing;
   pni_store_t *incoming;
   pn_list_t *subscriptions;
+  pn_list_t *warm;  // addresses kept connected, see pn_messenger_warm
+  pn_list_t *stripes;  // striping rules, see pn_messenger_stripe
   pn_subscription_t *incoming_subscription;
+  size_t next_subscription;  // slot pn_messenger_get serves next
+  int served;   // messages it has taken from that slot this turn
   pn_error_t *error;
   pn_transform_t *routes;
   pn_transform_t *rewrites;
@@ -97,6 +105,10 @@ struct pn_messenger_t {
   pn_string_t *domain;
   int timeout;
   int send_threshold;
+  int outgoing_limit;          // messages, 0 for no limit
+  size_t outgoing_byte_limit;  // encoded bytes, 0 for no limit
+  int outgoing_queued;         // deliveries queued on sender links
+  size_t outgoing_bytes;       // bytes buffered on sender links
   pn_link_credit_mode_t credit_mode;
   int credit_batch;  // when LINK_CREDIT_AUTO
   int credit;        // available
@@ -104,15 +116,23 @@ struct pn_messenger_t {
   int receivers;     // # receiver links
   int draining;      // # links in drain state
   int connection_error;
+  int accept_batch;  // max connections accepted per listener wakeup
+  int reconnect_initial;  // first reconnect delay for warm addresses
+  int reconnect_max;      // reconnect delay ceiling for warm addresses
   int flags;
   pn_snd_settle_mode_t snd_settle_mode;
   pn_rcv_settle_mode_t rcv_settle_mode;
   pn_tracer_t tracer;
+  pn_tracker_callback_t callback;  // default for outgoing trackers
+  void *callback_context;
   pn_ssl_verify_mode_t ssl_peer_authentication_mode;
   bool blocking;
   bool passive;
   bool interrupted;
   bool worked;
+  bool processing;  // inside pn_messenger_process, see pni_messenger_dirty
+  bool dirty;       // I/O happened that events and flow have not seen
+  bool reflow;      // a connection changed since credit was last flowed
 };
 
 #define CTX_HEAD                                \
@@ -142,6 +162,10 @@ typedef struct {
   char *host;
   char *port;
   pn_listener_ctx_t *listener;
+  int stripe;  // distinguishes connections opened for link striping
+  ssize_t output;  // transport output as of the last refresh
+  bool stale;      // connection modified since output was refreshed
+  pn_timestamp_t tick;  // when the transport next needs ticking, 0 if unknown
 } pn_connection_ctx_t;
 
 static pn_connection_ctx_t *pni_context(pn_selectable_t *sel)
@@ -160,6 +184,14 @@ static pn_transport_t *pni_transport(pn_selectable_t *sel)
 static ssize_t pni_connection_capacity(pn_selectable_t *sel)
 {
   pn_transport_t *transport = pni_transport(sel);
+  if (!transport) {
+    // an accepted connection whose transport is set up on first read
+    if (pn_connection_state(pni_context(sel)->connection) & PN_LOCAL_CLOSED) {
+      pni_selectable_set_terminal(sel, true);
+      return PN_EOS;
+    }
+    return 1;
+  }
   ssize_t capacity = pn_transport_capacity(transport);
   if (capacity < 0) {
     if (pn_transport_closed(transport)) {
@@ -171,24 +203,36 @@ static ssize_t pni_connection_capacity(pn_selectable_t *sel)
 
 bool pn_messenger_flow(pn_messenger_t *messenger);
 
+// The selector asks for pending output every time it updates a
+// connection's interest, so only run the transport, which processes
+// every modified endpoint, when the connection has actually been
+// modified since the last time. Credit is flowed separately, once
+// per wait, by pn_messenger_selectable.
 static ssize_t pni_connection_pending(pn_selectable_t *sel)
 {
   pn_connection_ctx_t *ctx = pni_context(sel);
-  pn_messenger_flow(ctx->messenger);
   pn_transport_t *transport = pni_transport(sel);
-  ssize_t pending = pn_transport_pending(transport);
-  if (pending < 0) {
+  if (!transport) return 0;
+  if (ctx->stale) {
+    ctx->output = pn_transport_pending(transport);
+    ctx->stale = false;
+  }
+  if (ctx->output < 0) {
     if (pn_transport_closed(transport)) {
       pni_selectable_set_terminal(sel, true);
     }
   }
-  return pending;
+  return ctx->output;
 }
 
 static pn_timestamp_t pni_connection_deadline(pn_selectable_t *sel)
 {
   pn_connection_ctx_t *ctx = pni_context(sel);
-  return ctx->messenger->next_drain;
+  pn_timestamp_t drain = ctx->messenger->next_drain;
+  if (ctx->tick && drain) {
+    return pn_min(ctx->tick, drain);
+  }
+  return ctx->tick ? ctx->tick : drain;
 }
 
 #include <errno.h>
@@ -210,6 +254,8 @@ void pni_modified(pn_ctx_t *ctx)
 
 void pni_conn_modified(pn_connection_ctx_t *ctx)
 {
+  ctx->stale = true;
+  ctx->messenger->reflow = true;
   pni_modified((pn_ctx_t *) ctx);
 }
 
@@ -219,6 +265,45 @@ void pni_lnr_modified(pn_listener_ctx_t *lnr)
 }
 
 int pn_messenger_process_events(pn_messenger_t *messenger);
+static pn_transport_t *pni_connection_accepted(pn_connection_ctx_t *ctx);
+
+// Passive messengers are driven through their selectables rather than
+// pn_messenger_process, and puts happen between passes, so outside a
+// pass read the clock afresh.
+static pn_timestamp_t pni_messenger_now(pn_messenger_t *messenger)
+{
+  if (!messenger->processing) {
+    messenger->now = pn_i_monotonic_ms();
+  }
+  return messenger->now;
+}
+
+// Run the transport's timers and remember when they next fall due, so
+// the connection's selectable deadline wakes us only when a tick is
+// actually needed rather than ticking every connection on every pass.
+static void pni_connection_tick(pn_connection_ctx_t *ctx)
+{
+  pn_transport_t *transport = pn_connection_transport(ctx->connection);
+  if (!transport) return;
+  ctx->tick = pn_transport_tick(transport, pni_messenger_now(ctx->messenger));
+  pni_conn_modified(ctx);
+}
+
+// Called after socket I/O on a connection. Within pn_messenger_process
+// the event drain and credit redistribution are deferred so they run
+// once per pass over the ready selectables rather than once per
+// connection. Passive messengers drive the selectables themselves and
+// so are processed immediately.
+static void pni_messenger_dirty(pn_messenger_t *messenger)
+{
+  if (messenger->processing) {
+    messenger->dirty = true;
+  } else {
+    pni_messenger_now(messenger);
+    pn_messenger_process_events(messenger);
+    pn_messenger_flow(messenger);
+  }
+}
 
 static void pni_connection_readable(pn_selectable_t *sel)
 {
@@ -226,6 +311,14 @@ static void pni_connection_readable(pn_selectable_t *sel)
   pn_messenger_t *messenger = context->messenger;
   pn_connection_t *connection = context->connection;
   pn_transport_t *transport = pni_transport(sel);
+  if (!transport) {
+    transport = pni_connection_accepted(context);
+    if (!transport) {
+      pn_connection_close(connection);
+      pni_conn_modified(context);
+      return;
+    }
+  }
   ssize_t capacity = pn_transport_capacity(transport);
   if (capacity > 0) {
     ssize_t n = pn_recv(messenger->io, pn_selectable_fd(sel),
@@ -245,8 +338,13 @@ static void pni_connection_readable(pn_selectable_t *sel)
     }
   }
 
-  pn_messenger_process_events(messenger);
-  pn_messenger_flow(messenger);
+  // input may carry the peer's idle timeout, so keep ticking until the
+  // transport reports a deadline
+  if (!context->tick) {
+    pni_connection_tick(context);
+  }
+
+  pni_messenger_dirty(messenger);
   messenger->worked = true;
   pni_conn_modified(context);
 }
@@ -256,7 +354,7 @@ static void pni_connection_writable(pn_selectable_t *sel)
   pn_connection_ctx_t *context = pni_context(sel);
   pn_messenger_t *messenger = context->messenger;
   pn_transport_t *transport = pni_transport(sel);
-  ssize_t pending = pn_transport_pending(transport);
+  ssize_t pending = transport ? pn_transport_pending(transport) : 0;
   if (pending > 0) {
     ssize_t n = pn_send(messenger->io, pn_selectable_fd(sel),
                         pn_transport_head(transport), pending);
@@ -270,8 +368,7 @@ static void pni_connection_writable(pn_selectable_t *sel)
     }
   }
 
-  pn_messenger_process_events(messenger);
-  pn_messenger_flow(messenger);
+  pni_messenger_dirty(messenger);
   messenger->worked = true;
   pni_conn_modified(context);
 }
@@ -279,7 +376,10 @@ static void pni_connection_writable(pn_selectable_t *sel)
 static void pni_connection_expired(pn_selectable_t *sel)
 {
   pn_connection_ctx_t *ctx = pni_context(sel);
-  pn_messenger_flow(ctx->messenger);
+  if (ctx->tick && ctx->tick <= pni_messenger_now(ctx->messenger)) {
+    pni_connection_tick(ctx);
+  }
+  pni_messenger_dirty(ctx->messenger);
   ctx->messenger->worked = true;
   pni_conn_modified(ctx);
 }
@@ -322,23 +422,45 @@ pn_connection_t *pn_messenger_connection(pn_messenger_t *messenger,
 static void pni_listener_readable(pn_selectable_t *sel)
 {
   pn_listener_ctx_t *ctx = (pn_listener_ctx_t *) pni_selectable_get_context(sel);
+  pn_messenger_t *messenger = ctx->messenger;
   pn_subscription_t *sub = ctx->subscription;
   const char *scheme = pn_subscription_scheme(sub);
   char name[1024];
-  pn_socket_t sock = pn_accept(ctx->messenger->io, pn_selectable_fd(sel), name, 1024);
+
+  // Drain up to a batch of pending connections per wakeup. Only the
+  // connection itself is created here, the transport, SSL and SASL
+  // state is set up by pni_connection_accepted once the peer sends
+  // its first bytes.
+  for (int i = 0; i < messenger->accept_batch; i++) {
+    pn_socket_t sock = pn_accept(messenger->io, pn_selectable_fd(sel), name, 1024);
+    if (sock == PN_INVALID_SOCKET) {
+      if (!pn_wouldblock(messenger->io)) {
+        pn_error_report("LISTENER", pn_error_text(pn_io_error(messenger->io)));
+        pn_error_clear(pn_io_error(messenger->io));
+      }
+      break;
+    }
+    pn_messenger_connection(messenger, sock, scheme, NULL, NULL, NULL, NULL, ctx);
+  }
+}
+
+static pn_transport_t *pni_connection_accepted(pn_connection_ctx_t *ctx)
+{
+  pn_listener_ctx_t *lnr = ctx->listener;
+  if (!lnr) return NULL;
 
   pn_transport_t *t = pn_transport();
 
   pn_ssl_t *ssl = pn_ssl(t);
-  pn_ssl_init(ssl, ctx->domain, NULL);
+  pn_ssl_init(ssl, lnr->domain, NULL);
   pn_sasl_t *sasl = pn_sasl(t);
 
   pn_sasl_mechanisms(sasl, "ANONYMOUS");
   pn_sasl_server(sasl);
   pn_sasl_done(sasl, PN_SASL_OK);
 
-  pn_connection_t *conn = pn_messenger_connection(ctx->messenger, sock, scheme, NULL, NULL, NULL, NULL, ctx);
-  pn_transport_bind(t, conn);
+  pn_transport_bind(t, ctx->connection);
+  return t;
 }
 
 static void pni_listener_writable(pn_selectable_t *sel)
@@ -375,12 +497,39 @@ static const char *default_port(const char *scheme)
     return "5672";
 }
 
+// amqp+unix://%2Fpath%2Fto%2Fsocket/node connects over a filesystem
+// unix domain socket, amqp+unix://name/node over the abstract
+// namespace socket "name"
+static bool pni_unix_scheme(const char *scheme)
+{
+  return scheme && pn_streq(scheme, "amqp+unix");
+}
+
+// maps an address host onto the host and port given to pn_listen and
+// pn_connect, using buf for abstract socket names
+static const char *pni_socket_host(const char *scheme, const char *host,
+                                   const char **port, char *buf, size_t size)
+{
+  if (!pni_unix_scheme(scheme)) {
+    if (!*port) *port = default_port(scheme);
+    return host;
+  }
+
+  *port = NULL;
+  if (host[0] == '/') return host;
+  snprintf(buf, size, "@%s", host);
+  return buf;
+}
+
 static pn_listener_ctx_t *pn_listener_ctx(pn_messenger_t *messenger,
                                           const char *scheme,
                                           const char *host,
                                           const char *port)
 {
-  pn_socket_t socket = pn_listen(messenger->io, host, port ? port : default_port(scheme));
+  char path[1024];
+  const char *sport = port;
+  const char *shost = pni_socket_host(scheme, host, &sport, path, 1024);
+  pn_socket_t socket = pn_listen(messenger->io, shost, sport);
   if (socket == PN_INVALID_SOCKET) {
     pn_error_copy(messenger->error, pn_io_error(messenger->io));
     pn_error_format(messenger->error, PN_ERR, "CONNECTION ERROR (%s:%s): %s\n",
@@ -436,6 +585,13 @@ static pn_listener_ctx_t *pn_listener_ctx(pn_messenger_t *messenger,
 static void pn_listener_ctx_free(pn_messenger_t *messenger, pn_listener_ctx_t *ctx)
 {
   pn_list_remove(messenger->listeners, ctx);
+  for (size_t i = 0; i < pn_list_size(messenger->connections); i++) {
+    pn_connection_t *conn = (pn_connection_t *) pn_list_get(messenger->connections, i);
+    pn_connection_ctx_t *cctx = (pn_connection_ctx_t *) pn_connection_get_context(conn);
+    if (cctx->listener == ctx) {
+      cctx->listener = NULL;
+    }
+  }
   // XXX: subscriptions are freed when the messenger is freed pn_subscription_free(ctx->subscription);
   free(ctx->host);
   free(ctx->port);
@@ -475,6 +631,10 @@ static pn_connection_ctx_t *pn_connection_ctx(pn_messenger_t *messenger,
   ctx->host = pn_strdup(host);
   ctx->port = pn_strdup(port);
   ctx->listener = lnr;
+  ctx->stripe = 0;
+  ctx->output = 0;
+  ctx->stale = true;
+  ctx->tick = 0;
   pn_connection_set_context(conn, ctx);
 
   return ctx;
@@ -513,8 +673,13 @@ static char *build_name(const char *name)
 
 struct pn_link_ctx_t {
   pn_subscription_t *subscription;
+  int queued;    // sender: pn_link_queued when last accounted
+  size_t bytes;  // sender: pn_link_outgoing_bytes when last accounted
+  bool striped;  // sender: one of the links of a striped address
 };
 
+static void pni_stripe_forget(pn_messenger_t *messenger, pn_link_t *link);
+
 // compute the maximum amount of credit each receiving link is
 // entitled to.  The actual credit given to the link depends on what
 // amount of credit is actually available.
@@ -529,21 +694,21 @@ static void link_ctx_setup( pn_messenger_t *messenger,
                             pn_connection_t *connection,
                             pn_link_t *link )
 {
+  pn_link_ctx_t *ctx = (pn_link_ctx_t *) calloc(1, sizeof(pn_link_ctx_t));
+  assert( ctx );
+  assert( !pn_link_get_context(link) );
+  pn_link_set_context( link, ctx );
   if (pn_link_is_receiver(link)) {
     messenger->receivers++;
-    pn_link_ctx_t *ctx = (pn_link_ctx_t *) calloc(1, sizeof(pn_link_ctx_t));
-    assert( ctx );
-    assert( !pn_link_get_context(link) );
-    pn_link_set_context( link, ctx );
     pn_list_add(messenger->blocked, link);
   }
 }
 
 static void link_ctx_release( pn_messenger_t *messenger, pn_link_t *link )
 {
+  pn_link_ctx_t *ctx = (pn_link_ctx_t *) pn_link_get_context( link );
+  if (!ctx) return;
   if (pn_link_is_receiver(link)) {
-    pn_link_ctx_t *ctx = (pn_link_ctx_t *) pn_link_get_context( link );
-    if (!ctx) return;
     assert( messenger->receivers > 0 );
     messenger->receivers--;
     if (pn_link_get_drain(link)) {
@@ -553,9 +718,28 @@ static void link_ctx_release( pn_messenger_t *messenger, pn_link_t *link )
     }
     pn_list_remove(messenger->credited, link);
     pn_list_remove(messenger->blocked, link);
-    pn_link_set_context( link, NULL );
-    free( ctx );
+  } else {
+    messenger->outgoing_queued -= ctx->queued;
+    messenger->outgoing_bytes -= ctx->bytes;
+    if (ctx->striped) pni_stripe_forget(messenger, link);
   }
+  pn_link_set_context( link, NULL );
+  free( ctx );
+}
+
+// Fold whatever a sender link queued or wrote since it was last looked
+// at into the messenger's running totals, so the outgoing limits never
+// have to walk the links.
+static void pni_sender_account( pn_messenger_t *messenger, pn_link_t *sender )
+{
+  pn_link_ctx_t *ctx = (pn_link_ctx_t *) pn_link_get_context( sender );
+  if (!ctx) return;
+  int queued = pn_link_queued(sender);
+  size_t bytes = pn_link_outgoing_bytes(sender);
+  messenger->outgoing_queued += queued - ctx->queued;
+  messenger->outgoing_bytes += bytes - ctx->bytes;
+  ctx->queued = queued;
+  ctx->bytes = bytes;
 }
 
 static ssize_t pni_interruptor_capacity(pn_selectable_t *sel)
@@ -612,6 +796,7 @@ pn_messenger_t *pn_messenger(const char *name)
     m->passive = false;
     m->io = pn_io();
     m->pending = pn_list(PN_WEAKREF, 0);
+    m->writable = pn_list(PN_WEAKREF, 0);
     m->interruptor = pni_selectable
       (pni_interruptor_capacity, pni_interruptor_pending,
        pni_interruptor_deadline, pni_interruptor_readable,
@@ -619,6 +804,9 @@ pn_messenger_t *pn_messenger(const char *name)
        pni_interruptor_finalize);
     pn_list_add(m->pending, m->interruptor);
     m->interrupted = false;
+    m->processing = false;
+    m->dirty = false;
+    m->reflow = false;
     // Explicitly initialise pipe file descriptors to invalid values in case pipe
     // fails, if we don't do this m->ctrl[0] could default to 0 - which is stdin.
     m->ctrl[0] = -1;
@@ -632,18 +820,32 @@ pn_messenger_t *pn_messenger(const char *name)
     m->collector = pn_collector();
     m->credit_mode = LINK_CREDIT_EXPLICIT;
     m->credit_batch = 1024;
+    m->accept_batch = 16;
+    m->reconnect_initial = 100;
+    m->reconnect_max = 10000;
     m->credit = 0;
     m->distributed = 0;
     m->receivers = 0;
     m->draining = 0;
     m->credited = pn_list(PN_WEAKREF, 0);
     m->blocked = pn_list(PN_WEAKREF, 0);
+    m->now = pn_i_monotonic_ms();
+    m->epoch = pn_i_monotonic_epoch();
     m->next_drain = 0;
+    m->next_expiry = 0;
+    m->outgoing_limit = 0;
+    m->outgoing_byte_limit = 0;
+    m->outgoing_queued = 0;
+    m->outgoing_bytes = 0;
     m->next_tag = 0;
     m->outgoing = pni_store();
     m->incoming = pni_store();
     m->subscriptions = pn_list(PN_OBJECT, 0);
+    m->warm = pn_list(PN_OBJECT, 0);
+    m->stripes = pn_list(PN_OBJECT, 0);
     m->incoming_subscription = NULL;
+    m->next_subscription = 0;
+    m->served = 0;
     m->error = pn_error();
     m->routes = pn_transform();
     m->rewrites = pn_transform();
@@ -658,6 +860,8 @@ pn_messenger_t *pn_messenger(const char *name)
     m->snd_settle_mode = PN_SND_SETTLED;
     m->rcv_settle_mode = PN_RCV_FIRST;
     m->tracer = NULL;
+    m->callback = NULL;
+    m->callback_context = NULL;
     m->ssl_peer_authentication_mode = PN_SSL_VERIFY_PEER_NAME;
   }
 
@@ -762,6 +966,10 @@ int pn_messenger_set_passive(pn_messenger_t *messenger, bool passive)
 pn_selectable_t *pn_messenger_selectable(pn_messenger_t *messenger)
 {
   assert(messenger);
+  if (messenger->reflow) {
+    messenger->reflow = false;
+    pn_messenger_flow(messenger);
+  }
   pn_messenger_process_events(messenger);
   pn_list_t *p = messenger->pending;
   size_t n = pn_list_size(p);
@@ -782,6 +990,7 @@ pn_selectable_t *pn_messenger_selectable(pn_messenger_t *messenger)
   }
 }
 
+
 static void pni_reclaim(pn_messenger_t *messenger)
 {
   while (pn_list_size(messenger->listeners)) {
@@ -807,8 +1016,12 @@ void pn_messenger_free(pn_messenger_t *messenger)
     free(messenger->private_key);
     free(messenger->password);
     free(messenger->trusted_certificates);
+    pn_list_clear(messenger->warm);
     pni_reclaim(messenger);
+    pn_free(messenger->warm);
+    pn_free(messenger->stripes);
     pn_free(messenger->pending);
+    pn_free(messenger->writable);
     pn_selectable_free(messenger->interruptor);
     pn_close(messenger->io, messenger->ctrl[0]);
     pn_close(messenger->io, messenger->ctrl[1]);
@@ -885,9 +1098,9 @@ bool pn_messenger_flow(pn_messenger_t *messenger)
     if (!messenger->draining) {
       //      printf("%s: let's drain\n", messenger->name);
       if (messenger->next_drain == 0) {
-        messenger->next_drain = pn_i_now() + 250;
+        messenger->next_drain = messenger->now + 250;
         //        printf("%s: initializing next_drain\n", messenger->name);
-      } else if (messenger->next_drain <= pn_i_now()) {
+      } else if (messenger->next_drain <= messenger->now) {
         // initiate drain, free up at most enough to satisfy blocked
         messenger->next_drain = 0;
         int needed = pn_list_size(messenger->blocked) * batch;
@@ -983,19 +1196,20 @@ static void pn_condition_report(const char *pfx, pn_condition_t *condition)
   }
 }
 
-int pni_pump_in(pn_messenger_t *messenger, const char *address, pn_link_t *receiver)
+int pni_pump_in(pn_messenger_t *messenger, pn_link_t *receiver)
 {
   pn_delivery_t *d = pn_link_current(receiver);
   if (!pn_delivery_readable(d) && !pn_delivery_partial(d)) {
     return 0;
   }
 
-  pni_entry_t *entry = pni_store_put(messenger->incoming, address);
+  // incoming messages are queued per subscription
+  pn_link_ctx_t *ctx = (pn_link_ctx_t *) pn_link_get_context( receiver );
+  pn_subscription_t *sub = ctx ? ctx->subscription : NULL;
+  pni_entry_t *entry = pni_store_put_keyed(messenger->incoming, sub);
   pn_buffer_t *buf = pni_entry_bytes(entry);
   pni_entry_set_delivery(entry, d);
-
-  pn_link_ctx_t *ctx = (pn_link_ctx_t *) pn_link_get_context( receiver );
-  pni_entry_set_context(entry, ctx ? ctx->subscription : NULL);
+  pni_entry_set_context(entry, sub);
 
   size_t pending = pn_delivery_pending(d);
   int err = pn_buffer_ensure(buf, pending + 1);
@@ -1047,11 +1261,175 @@ int pni_pump_in(pn_messenger_t *messenger, const char *address, pn_link_t *recei
   if (n != PN_EOS) {
     return pn_error_format(messenger->error, n, "PN_EOS expected");
   }
-  pn_buffer_append(buf, encoded, pending); // XXX
+  pni_entry_append(entry, encoded, pending); // XXX
 
   return 0;
 }
 
+// A warm address is one the application asked to keep connected with
+// pn_messenger_warm. While its connection is up the entry holds on to
+// the sender link so puts to the address can skip routing and
+// resolution; once the link or connection is lost the entry waits out
+// the current backoff and then reconnects, doubling the backoff on
+// each failure until the peer opens the connection again.
+typedef struct {
+  pn_string_t *address;
+  pn_connection_t *connection;  // NULL while waiting to reconnect
+  pn_link_t *link;              // NULL while waiting to reconnect
+  pn_timestamp_t retry;         // when to reconnect, 0 if connected
+  int backoff;                  // delay before the next reconnect (ms)
+} pni_warm_t;
+
+static void pni_warm_initialize(void *object)
+{
+  pni_warm_t *warm = (pni_warm_t *) object;
+  warm->address = NULL;
+  warm->connection = NULL;
+  warm->link = NULL;
+  warm->retry = 0;
+  warm->backoff = 0;
+}
+
+static void pni_warm_finalize(void *object)
+{
+  pni_warm_t *warm = (pni_warm_t *) object;
+  pn_free(warm->address);
+}
+
+#define CID_pni_warm CID_pn_object
+#define pni_warm_hashcode NULL
+#define pni_warm_compare NULL
+#define pni_warm_inspect NULL
+
+static pni_warm_t *pni_warm(const char *address, int backoff)
+{
+  static const pn_class_t clazz = PN_CLASS(pni_warm);
+  pni_warm_t *warm = (pni_warm_t *) pn_class_new(&clazz, sizeof(pni_warm_t));
+  warm->address = pn_string(address);
+  warm->backoff = backoff;
+  return warm;
+}
+
+pn_link_t *pni_messenger_warm_link(pn_messenger_t *messenger, const char *address)
+{
+  for (size_t i = 0; i < pn_list_size(messenger->warm); i++) {
+    pni_warm_t *warm = (pni_warm_t *) pn_list_get(messenger->warm, i);
+    if (warm->link && pn_streq(pn_string_get(warm->address), address)) {
+      return warm->link;
+    }
+  }
+  return NULL;
+}
+
+static void pni_warm_schedule(pn_messenger_t *messenger, pni_warm_t *warm)
+{
+  warm->connection = NULL;
+  warm->link = NULL;
+  warm->retry = messenger->now + warm->backoff;
+  warm->backoff = pn_min(2*warm->backoff, messenger->reconnect_max);
+}
+
+static void pni_warm_lost(pn_messenger_t *messenger, pn_connection_t *conn)
+{
+  for (size_t i = 0; i < pn_list_size(messenger->warm); i++) {
+    pni_warm_t *warm = (pni_warm_t *) pn_list_get(messenger->warm, i);
+    if (warm->connection == conn) {
+      pni_warm_schedule(messenger, warm);
+    }
+  }
+}
+
+// the peer closed a warm link, drop it and open a fresh one later
+static void pni_warm_closed(pn_messenger_t *messenger, pn_link_t *link)
+{
+  for (size_t i = 0; i < pn_list_size(messenger->warm); i++) {
+    pni_warm_t *warm = (pni_warm_t *) pn_list_get(messenger->warm, i);
+    if (warm->link == link) {
+      pni_warm_schedule(messenger, warm);
+    }
+  }
+}
+
+static void pni_warm_opened(pn_messenger_t *messenger, pn_connection_t *conn)
+{
+  for (size_t i = 0; i < pn_list_size(messenger->warm); i++) {
+    pni_warm_t *warm = (pni_warm_t *) pn_list_get(messenger->warm, i);
+    if (warm->connection == conn) {
+      warm->backoff = messenger->reconnect_initial;
+    }
+  }
+}
+
+static pn_timestamp_t pni_warm_deadline(pn_messenger_t *messenger)
+{
+  pn_timestamp_t deadline = 0;
+  for (size_t i = 0; i < pn_list_size(messenger->warm); i++) {
+    pni_warm_t *warm = (pni_warm_t *) pn_list_get(messenger->warm, i);
+    if (warm->retry) {
+      deadline = deadline ? pn_min(deadline, warm->retry) : warm->retry;
+    }
+  }
+  return deadline;
+}
+
+// Report a change to an outgoing tracker, preferring the callback
+// given at put time over the messenger wide one.
+static void pni_entry_notify(pn_messenger_t *messenger, pni_entry_t *entry)
+{
+  pn_tracker_callback_t callback = pni_entry_get_callback(entry);
+  void *context = pni_entry_get_callback_context(entry);
+  if (!callback) {
+    callback = messenger->callback;
+    context = messenger->callback_context;
+  }
+  if (callback) {
+    callback(messenger, pn_tracker(OUTGOING, pni_entry_id(entry)),
+             pni_entry_get_status(entry), context);
+  }
+}
+
+// Abort messages that expired while their delivery was waiting for
+// credit. Deliveries that have started transfer are left to finish.
+static void pni_messenger_expire(pn_messenger_t *messenger)
+{
+  pn_timestamp_t now = messenger->now;
+  if (!messenger->next_expiry || now < messenger->next_expiry) return;
+
+  messenger->next_expiry = 0;
+  for (size_t i = 0; i < pn_list_size(messenger->connections); i++) {
+    pn_connection_t *conn = (pn_connection_t *) pn_list_get(messenger->connections, i);
+    pn_link_t *link = pn_link_head(conn, PN_LOCAL_ACTIVE);
+    while (link) {
+      if (pn_link_is_sender(link)) {
+        pn_delivery_t *d = pn_unsettled_head(link);
+        while (d) {
+          pn_delivery_t *next = pn_unsettled_next(d);
+          pni_entry_t *e = (pni_entry_t *) pn_delivery_get_context(d);
+          if (e && pn_delivery_buffered(d)) {
+            if (pni_entry_expired(e, now)) {
+              // a delivery whose transfer has already started can no
+              // longer be withdrawn; it goes out as is, so its expiry
+              // must not keep the deadline in the past
+              if (!pn_delivery_abort(d)) {
+                pni_entry_set_delivery(e, NULL);
+                pni_entry_set_status(e, PN_STATUS_ABORTED);
+                pni_entry_notify(messenger, e);
+                pni_sender_account(messenger, link);
+              }
+            } else if (pni_entry_get_expiry(e)) {
+              pn_timestamp_t expiry = pni_entry_get_expiry(e);
+              messenger->next_expiry = messenger->next_expiry ?
+                pn_min(messenger->next_expiry, expiry) : expiry;
+            }
+          }
+          d = next;
+        }
+      }
+      link = pn_link_next(link, PN_LOCAL_ACTIVE);
+    }
+  }
+}
+
 void pni_messenger_reclaim_link(pn_messenger_t *messenger, pn_link_t *link)
 {
   if (pn_link_is_receiver(link) && pn_link_credit(link) > 0) {
@@ -1067,6 +1445,7 @@ void pni_messenger_reclaim_link(pn_messenger_t *messenger, pn_link_t *link)
       pni_entry_set_delivery(e, NULL);
       if (pn_delivery_buffered(d)) {
         pni_entry_set_status(e, PN_STATUS_ABORTED);
+        if (pn_link_is_sender(link)) pni_entry_notify(messenger, e);
       }
     }
     d = pn_unsettled_next(d);
@@ -1085,6 +1464,7 @@ void pni_messenger_reclaim(pn_messenger_t *messenger, pn_connection_t *conn)
     link = pn_link_next(link, 0);
   }
 
+  pni_warm_lost(messenger, conn);
   pn_list_remove(messenger->connections, conn);
   pn_connection_ctx_free(conn);
   pn_transport_free(pn_connection_transport(conn));
@@ -1122,6 +1502,10 @@ void pn_messenger_process_connection(pn_messenger_t *messenger, pn_event_t *even
     pn_connection_open(conn);
   }
 
+  if (pn_connection_state(conn) == (PN_LOCAL_ACTIVE | PN_REMOTE_ACTIVE)) {
+    pni_warm_opened(messenger, conn);
+  }
+
   if (pn_connection_state(conn) == (PN_LOCAL_ACTIVE | PN_REMOTE_CLOSED)) {
     pn_condition_t *condition = pn_connection_remote_condition(conn);
     pn_condition_report("CONNECTION", condition);
@@ -1187,6 +1571,7 @@ void pn_messenger_process_link(pn_messenger_t *messenger, pn_event_t *event)
     if (PN_LOCAL_ACTIVE & pn_link_state(link)) {
       pn_condition_report("LINK", pn_link_remote_condition(link));
       pn_link_close(link);
+      pni_warm_closed(messenger, link);
       pni_messenger_reclaim_link(messenger, link);
       pn_link_free(link);
     }
@@ -1201,6 +1586,8 @@ void pn_messenger_process_flow(pn_messenger_t *messenger, pn_event_t *event)
 
   if (pn_link_is_sender(link)) {
     pni_pump_out(messenger, pn_terminus_get_address(pn_link_target(link)), link);
+    // the transport raises flow on every transfer it writes
+    pni_sender_account(messenger, link);
   } else {
     // account for any credit left over after draining links has completed
     if (pn_link_get_drain(link)) {
@@ -1228,11 +1615,14 @@ void pn_messenger_process_delivery(pn_messenger_t *messenger, pn_event_t *event)
       pn_delivery_update(d, pn_delivery_remote_state(d));
     }
     pni_entry_t *e = (pni_entry_t *) pn_delivery_get_context(d);
-    if (e) pni_entry_updated(e);
+    if (e) {
+      pni_entry_updated(e);
+      if (pn_link_is_sender(link)) pni_entry_notify(messenger, e);
+    }
   }
   pn_delivery_clear(d);
   if (pn_delivery_readable(d)) {
-    int err = pni_pump_in(messenger, pn_terminus_get_address(pn_link_source(link)), link);
+    int err = pni_pump_in(messenger, link);
     if (err) {
       fprintf(stderr, "%s\n", pn_error_text(messenger->error));
     }
@@ -1316,56 +1706,55 @@ int pn_messenger_process_events(pn_messenger_t *messenger)
   return processed;
 }
 
-/**
- * Function to invoke AMQP related timer events, such as a heartbeat to prevent
- * remote_idle timeout events
- */
-static void pni_messenger_tick(pn_messenger_t *messenger)
-{
-  for (size_t i = 0; i < pn_list_size(messenger->connections); i++) {
-    pn_connection_t *connection =
-        (pn_connection_t *)pn_list_get(messenger->connections, i);
-    pn_transport_t *transport = pn_connection_transport(connection);
-    if (transport) {
-      pn_transport_tick(transport, pn_i_now());
-
-      // if there is pending data, such as an empty heartbeat frame, call
-      // process events. This should kick off the chain of selectables for
-      // reading/writing.
-      ssize_t pending = pn_transport_pending(transport);
-      if (pending > 0) {
-        pn_connection_ctx_t *cctx =
-            (pn_connection_ctx_t *)pn_connection_get_context(connection);
-        pn_messenger_process_events(messenger);
-        pn_messenger_flow(messenger);
-        pni_conn_modified(pni_context(cctx->selectable));
-      }
-    }
-  }
-}
+static void pni_warm_retry(pn_messenger_t *messenger);
 
 int pn_messenger_process(pn_messenger_t *messenger)
 {
-  bool doMessengerTick = true;
   pn_selectable_t *sel;
   int events;
+
+  // every deadline checked during this pass shares one clock reading
+  messenger->now = pn_i_monotonic_ms();
+  messenger->epoch = pn_i_monotonic_epoch();
+
+  // Read from every ready selectable first, then process events and
+  // redistribute credit once, then write, so that output generated in
+  // response to this pass's input goes out without another wakeup.
+  messenger->processing = true;
   while ((sel = pn_selector_next(messenger->selector, &events))) {
     if (events & PN_READABLE) {
       pn_selectable_readable(sel);
     }
     if (events & PN_WRITABLE) {
-      pn_selectable_writable(sel);
-      doMessengerTick = false;
+      pn_list_add(messenger->writable, sel);
     }
     if (events & PN_EXPIRED) {
       pn_selectable_expired(sel);
+      // a tick may have produced a heartbeat, send it this pass
+      if (!(events & PN_WRITABLE)) {
+        pn_list_add(messenger->writable, sel);
+      }
     }
   }
-  // ensure timer events are processed. Cannot call this inside the while loop
-  // as the timer events are not seen by the selector
-  if (doMessengerTick) {
-    pni_messenger_tick(messenger);
+  if (messenger->dirty) {
+    messenger->dirty = false;
+    pn_messenger_process_events(messenger);
+    pn_messenger_flow(messenger);
+  }
+  for (size_t i = 0; i < pn_list_size(messenger->writable); i++) {
+    pn_selectable_writable((pn_selectable_t *) pn_list_get(messenger->writable, i));
+  }
+  pn_list_clear(messenger->writable);
+  messenger->processing = false;
+  // writing only releases buffered output, so there is no credit to
+  // redistribute, but the transport may have posted events
+  if (messenger->dirty) {
+    messenger->dirty = false;
+    pn_messenger_process_events(messenger);
   }
+
+  pni_warm_retry(messenger);
+  pni_messenger_expire(messenger);
   if (messenger->interrupted) {
     messenger->interrupted = false;
     return PN_INTR;
@@ -1374,11 +1763,26 @@ int pn_messenger_process(pn_messenger_t *messenger)
   }
 }
 
-pn_timestamp_t pn_messenger_deadline(pn_messenger_t *messenger)
+static pn_timestamp_t pni_messenger_deadline(pn_messenger_t *messenger)
 {
   // If the scheduler detects credit imbalance on the links, wake up
-  // in time to service credit drain
-  return messenger->next_drain;
+  // in time to service credit drain, and likewise for any warm
+  // address that is due to reconnect or outgoing message that is due
+  // to expire
+  pn_timestamp_t deadline = pni_warm_deadline(messenger);
+  if (messenger->next_drain) {
+    deadline = deadline ? pn_min(deadline, messenger->next_drain) : messenger->next_drain;
+  }
+  if (messenger->next_expiry) {
+    deadline = deadline ? pn_min(deadline, messenger->next_expiry) : messenger->next_expiry;
+  }
+  return deadline;
+}
+
+pn_timestamp_t pn_messenger_deadline(pn_messenger_t *messenger)
+{
+  pn_timestamp_t deadline = pni_messenger_deadline(messenger);
+  return deadline ? deadline + messenger->epoch : 0;
 }
 
 int pni_wait(pn_messenger_t *messenger, int timeout)
@@ -1415,12 +1819,13 @@ int pn_messenger_tsync(pn_messenger_t *messenger, bool (*predicate)(pn_messenger
     return pred ? 0 : PN_INPROGRESS;
   }
 
-  pn_timestamp_t now = pn_i_now();
+  pn_timestamp_t now = pn_i_monotonic_ms();
   long int deadline = now + timeout;
   bool pred;
 
   while (true) {
     int error = pn_messenger_process(messenger);
+    now = messenger->now;
     pred = predicate(messenger);
     if (error == PN_INTR) {
       return pred ? 0 : PN_INTR;
@@ -1428,7 +1833,7 @@ int pn_messenger_tsync(pn_messenger_t *messenger, bool (*predicate)(pn_messenger
     int remaining = deadline - now;
     if (pred || (timeout >= 0 && remaining < 0)) break;
 
-    pn_timestamp_t mdeadline = pn_messenger_deadline(messenger);
+    pn_timestamp_t mdeadline = pni_messenger_deadline(messenger);
     if (mdeadline) {
       if (now >= mdeadline)
         remaining = 0;
@@ -1439,10 +1844,6 @@ int pn_messenger_tsync(pn_messenger_t *messenger, bool (*predicate)(pn_messenger
     }
     error = pni_wait(messenger, remaining);
     if (error) return error;
-
-    if (timeout >= 0) {
-      now = pn_i_now();
-    }
   }
 
   return pred ? 0 : PN_TIMEOUT;
@@ -1568,6 +1969,9 @@ int pn_messenger_stop(pn_messenger_t *messenger)
     pni_lnr_modified(lnr);
   }
 
+  // the connections being closed must not be reopened
+  pn_list_clear(messenger->warm);
+
   return pn_messenger_sync(messenger, pn_messenger_stopped);
 }
 
@@ -1586,6 +1990,9 @@ static void pni_parse(pn_address_t *address)
     address->passive = true;
     address->host++;
   }
+  if (pni_unix_scheme(address->scheme)) {
+    pni_urldecode(address->host, address->host);
+  }
 }
 
 static int pni_route(pn_messenger_t *messenger, const char *address)
@@ -1598,7 +2005,8 @@ static int pni_route(pn_messenger_t *messenger, const char *address)
   return 0;
 }
 
-pn_connection_t *pn_messenger_resolve(pn_messenger_t *messenger, const char *address, char **name)
+static pn_connection_t *pni_resolve(pn_messenger_t *messenger, const char *address,
+                                    char **name, int stripe)
 {
   assert(messenger);
   messenger->connection_error = 0;
@@ -1640,6 +2048,7 @@ pn_connection_t *pn_messenger_resolve(pn_messenger_t *messenger, const char *add
   for (size_t i = 0; i < pn_list_size(messenger->connections); i++) {
     pn_connection_t *connection = (pn_connection_t *) pn_list_get(messenger->connections, i);
     pn_connection_ctx_t *ctx = (pn_connection_ctx_t *) pn_connection_get_context(connection);
+    if (ctx->stripe != stripe) continue;
     if (pn_streq(scheme, ctx->scheme) && pn_streq(user, ctx->user) &&
         pn_streq(pass, ctx->pass) && pn_streq(host, ctx->host) &&
         pn_streq(port, ctx->port)) {
@@ -1651,13 +2060,17 @@ pn_connection_t *pn_messenger_resolve(pn_messenger_t *messenger, const char *add
     }
   }
 
-  pn_socket_t sock = pn_connect(messenger->io, host, port ? port : default_port(scheme));
+  char path[1024];
+  const char *sport = port;
+  const char *shost = pni_socket_host(scheme, host, &sport, path, 1024);
+  pn_socket_t sock = pn_connect(messenger->io, shost, sport);
   if (sock == PN_INVALID_SOCKET) {
     return NULL;
   }
 
   pn_connection_t *connection =
     pn_messenger_connection(messenger, sock, scheme, user, pass, host, port, NULL);
+  ((pn_connection_ctx_t *) pn_connection_get_context(connection))->stripe = stripe;
   pn_transport_t *transport = pn_transport();
   pn_transport_bind(transport, connection);
   err = pn_transport_config(messenger, connection);
@@ -1674,16 +2087,21 @@ pn_connection_t *pn_messenger_resolve(pn_messenger_t *messenger, const char *add
   return connection;
 }
 
-PN_EXTERN pn_link_t *pn_messenger_get_link(pn_messenger_t *messenger,
-                                           const char *address, bool sender)
+pn_connection_t *pn_messenger_resolve(pn_messenger_t *messenger, const char *address, char **name)
 {
-  char *name = NULL;
-  pn_connection_t *connection = pn_messenger_resolve(messenger, address, &name);
-  if (!connection) return NULL;
+  return pni_resolve(messenger, address, name, 0);
+}
 
+// Find a link on a connection by terminus address and, when link_name
+// is given, by name. Each stripe of an address is a sender link with
+// its own name.
+static pn_link_t *pni_find_link(pn_connection_t *connection, const char *name,
+                                bool sender, const char *link_name)
+{
   pn_link_t *link = pn_link_head(connection, PN_LOCAL_ACTIVE);
   while (link) {
-    if (pn_link_is_sender(link) == sender) {
+    if (pn_link_is_sender(link) == sender &&
+        (!link_name || pn_streq(link_name, pn_link_name(link)))) {
       const char *terminus = pn_link_is_sender(link) ?
         pn_terminus_get_address(pn_link_target(link)) :
         pn_terminus_get_address(pn_link_source(link));
@@ -1695,24 +2113,38 @@ PN_EXTERN pn_link_t *pn_messenger_get_link(pn_messenger_t *messenger,
   return NULL;
 }
 
-pn_link_t *pn_messenger_link(pn_messenger_t *messenger, const char *address,
-                             bool sender, pn_seconds_t timeout)
+PN_EXTERN pn_link_t *pn_messenger_get_link(pn_messenger_t *messenger,
+                                           const char *address, bool sender)
 {
   char *name = NULL;
   pn_connection_t *connection = pn_messenger_resolve(messenger, address, &name);
+  if (!connection) return NULL;
+  return pni_find_link(connection, name, sender, NULL);
+}
+
+static pn_link_t *pni_link(pn_messenger_t *messenger, const char *address,
+                           bool sender, pn_seconds_t timeout, int stripe,
+                           int conn_stripe)
+{
+  char *name = NULL;
+  pn_connection_t *connection = pni_resolve(messenger, address, &name, conn_stripe);
   if (!connection)
     return NULL;
   pn_connection_ctx_t *cctx =
       (pn_connection_ctx_t *)pn_connection_get_context(connection);
 
-  pn_link_t *link = pn_messenger_get_link(messenger, address, sender);
+  char link_name[32] = "sender-xxx";
+  if (stripe) snprintf(link_name, sizeof(link_name), "sender-xxx.%i", stripe);
+
+  pn_link_t *link = pni_find_link(connection, name, sender,
+                                  sender ? link_name : NULL);
   if (link)
     return link;
 
   pn_session_t *ssn = pn_session(connection);
   pn_session_open(ssn);
   if (sender) {
-    link = pn_sender(ssn, "sender-xxx");
+    link = pn_sender(ssn, link_name);
   } else {
     if (name) {
       link = pn_receiver(ssn, name);
@@ -1757,6 +2189,243 @@ pn_link_t *pn_messenger_link(pn_messenger_t *messenger, const char *address,
   return link;
 }
 
+pn_link_t *pn_messenger_link(pn_messenger_t *messenger, const char *address,
+                             bool sender, pn_seconds_t timeout)
+{
+  return pni_link(messenger, address, sender, timeout, 0, 0);
+}
+
+typedef struct {
+  pn_string_t *pattern;
+  int links;
+  int flags;
+  int next;            // where the search for the least loaded stripe starts
+  pn_list_t *targets;  // pni_stripe_target_t for each address seen
+} pni_stripe_t;
+
+static void pni_stripe_finalize(void *object)
+{
+  pni_stripe_t *stripe = (pni_stripe_t *) object;
+  pn_free(stripe->pattern);
+  pn_free(stripe->targets);
+}
+
+#define CID_pni_stripe CID_pn_object
+#define pni_stripe_initialize NULL
+#define pni_stripe_hashcode NULL
+#define pni_stripe_compare NULL
+#define pni_stripe_inspect NULL
+
+// The links a striped address has been given so far, so that puts
+// only route and resolve the address when a stripe has no link yet.
+typedef struct {
+  pn_string_t *address;
+  pn_link_t **links;  // one per stripe, NULL until opened or once closed
+} pni_stripe_target_t;
+
+static void pni_stripe_target_finalize(void *object)
+{
+  pni_stripe_target_t *target = (pni_stripe_target_t *) object;
+  pn_free(target->address);
+  free(target->links);
+}
+
+#define CID_pni_stripe_target CID_pn_object
+#define pni_stripe_target_initialize NULL
+#define pni_stripe_target_hashcode NULL
+#define pni_stripe_target_compare NULL
+#define pni_stripe_target_inspect NULL
+
+static pni_stripe_target_t *pni_stripe_target(pni_stripe_t *stripe, const char *address)
+{
+  for (size_t i = 0; i < pn_list_size(stripe->targets); i++) {
+    pni_stripe_target_t *target = (pni_stripe_target_t *) pn_list_get(stripe->targets, i);
+    if (pn_streq(pn_string_get(target->address), address)) return target;
+  }
+
+  static const pn_class_t clazz = PN_CLASS(pni_stripe_target);
+  pni_stripe_target_t *target =
+    (pni_stripe_target_t *) pn_class_new(&clazz, sizeof(pni_stripe_target_t));
+  target->address = pn_string(address);
+  target->links = (pn_link_t **) calloc(stripe->links, sizeof(pn_link_t *));
+  pn_list_add(stripe->targets, target);
+  pn_decref(target);
+  return target;
+}
+
+static pn_link_t *pni_stripe_link(pn_messenger_t *messenger, pni_stripe_t *stripe,
+                                  pni_stripe_target_t *target, int k)
+{
+  if (!target->links[k]) {
+    bool connections = stripe->flags & PN_STRIPE_CONNECTIONS;
+    pn_link_t *link = pni_link(messenger, pn_string_get(target->address), true, 0,
+                               k, connections ? k : 0);
+    if (!link) return NULL;
+    ((pn_link_ctx_t *) pn_link_get_context(link))->striped = true;
+    target->links[k] = link;
+  }
+  return target->links[k];
+}
+
+// A stripe link is going away: stop handing it out, and abort whatever
+// was still queued for it.
+static void pni_stripe_forget(pn_messenger_t *messenger, pn_link_t *link)
+{
+  for (size_t i = 0; i < pn_list_size(messenger->stripes); i++) {
+    pni_stripe_t *stripe = (pni_stripe_t *) pn_list_get(messenger->stripes, i);
+    for (size_t j = 0; j < pn_list_size(stripe->targets); j++) {
+      pni_stripe_target_t *target = (pni_stripe_target_t *) pn_list_get(stripe->targets, j);
+      for (int k = 0; k < stripe->links; k++) {
+        if (target->links[k] == link) target->links[k] = NULL;
+      }
+    }
+  }
+
+  pni_entry_t *entry;
+  while ((entry = pni_store_get_keyed(messenger->outgoing, link))) {
+    pni_entry_set_status(entry, PN_STATUS_ABORTED);
+    pni_entry_notify(messenger, entry);
+    pni_entry_free(entry);
+  }
+}
+
+int pn_messenger_stripe(pn_messenger_t *messenger, const char *pattern,
+                        int links, int flags)
+{
+  if (!messenger || !pattern || links < 1) return PN_ARG_ERR;
+  static const pn_class_t clazz = PN_CLASS(pni_stripe);
+  pni_stripe_t *stripe = (pni_stripe_t *) pn_class_new(&clazz, sizeof(pni_stripe_t));
+  stripe->pattern = pn_string(pattern);
+  stripe->links = links;
+  stripe->flags = flags;
+  stripe->next = 0;
+  stripe->targets = pn_list(PN_OBJECT, 0);
+  pn_list_add(messenger->stripes, stripe);
+  pn_decref(stripe);
+  return 0;
+}
+
+static uint32_t pni_group_hash(const char *group)
+{
+  // FNV-1a
+  uint32_t hash = 2166136261u;
+  while (*group) {
+    hash = (hash ^ (unsigned char) *group++) * 16777619u;
+  }
+  return hash;
+}
+
+// Pick the sender link a put should use. Unstriped addresses use the
+// same single link as pn_messenger_target. Striped addresses use the
+// stripe with the most unused credit, unless ordering was requested
+// and the message has a group id, in which case the group always maps
+// to the same stripe. Sets striped when the link is one of several
+// stripes.
+static pn_link_t *pni_target(pn_messenger_t *messenger, const char *address,
+                             pn_message_t *msg, bool *striped)
+{
+  pni_stripe_t *stripe = NULL;
+  for (size_t i = 0; i < pn_list_size(messenger->stripes); i++) {
+    pni_stripe_t *s = (pni_stripe_t *) pn_list_get(messenger->stripes, i);
+    if (pn_transform_match(pn_string_get(s->pattern), address)) {
+      stripe = s;
+      break;
+    }
+  }
+
+  if (!stripe || stripe->links == 1) {
+    pn_link_t *warm = pni_messenger_warm_link(messenger, address);
+    return warm ? warm : pni_link(messenger, address, true, 0, 0, 0);
+  }
+
+  *striped = true;
+  pni_stripe_target_t *target = pni_stripe_target(stripe, address);
+  const char *group = pn_message_get_group_id(msg);
+  if ((stripe->flags & PN_STRIPE_ORDERED) && group) {
+    int k = pni_group_hash(group) % stripe->links;
+    return pni_stripe_link(messenger, stripe, target, k);
+  }
+
+  pn_link_t *best = NULL;
+  int best_available = 0;
+  int best_k = 0;
+  for (int i = 0; i < stripe->links; i++) {
+    int k = (stripe->next + i) % stripe->links;
+    pn_link_t *link = pni_stripe_link(messenger, stripe, target, k);
+    if (!link) {
+      if (pn_error_code(messenger->error) || messenger->connection_error) {
+        return NULL;
+      }
+      continue;
+    }
+    int available = pn_link_credit(link) - pn_link_queued(link);
+    if (!best || available > best_available) {
+      best = link;
+      best_available = available;
+      best_k = k;
+    }
+  }
+  stripe->next = (best_k + 1) % stripe->links;
+  return best;
+}
+
+static void pni_warm_connect(pn_messenger_t *messenger, pni_warm_t *warm)
+{
+  pn_link_t *link = pn_messenger_link(messenger, pn_string_get(warm->address), true, 0);
+  if (link) {
+    warm->connection = pn_session_connection(pn_link_session(link));
+    warm->link = link;
+    warm->retry = 0;
+  } else {
+    pni_warm_schedule(messenger, warm);
+  }
+}
+
+static void pni_warm_retry(pn_messenger_t *messenger)
+{
+  if (!pn_list_size(messenger->warm)) return;
+
+  pn_timestamp_t now = messenger->now;
+  for (size_t i = 0; i < pn_list_size(messenger->warm); i++) {
+    pni_warm_t *warm = (pni_warm_t *) pn_list_get(messenger->warm, i);
+    if (warm->retry && warm->retry <= now) {
+      pni_warm_connect(messenger, warm);
+    }
+  }
+}
+
+int pn_messenger_warm(pn_messenger_t *messenger, const char *address)
+{
+  if (!messenger || !address) return PN_ARG_ERR;
+
+  for (size_t i = 0; i < pn_list_size(messenger->warm); i++) {
+    pni_warm_t *warm = (pni_warm_t *) pn_list_get(messenger->warm, i);
+    if (pn_streq(pn_string_get(warm->address), address)) return 0;
+  }
+
+  int err = pni_route(messenger, address);
+  if (err) return err;
+  if (messenger->address.passive) {
+    return pn_error_format(messenger->error, PN_ARG_ERR,
+                           "cannot warm a passive address: %s", address);
+  }
+
+  pni_warm_t *warm = pni_warm(address, messenger->reconnect_initial);
+  pn_list_add(messenger->warm, warm);
+  pn_decref(warm);
+
+  pni_warm_connect(messenger, warm);
+  return 0;
+}
+
+int pn_messenger_set_reconnect_backoff(pn_messenger_t *messenger, int initial, int max)
+{
+  if (initial <= 0 || max < initial) return PN_ARG_ERR;
+  messenger->reconnect_initial = initial;
+  messenger->reconnect_max = max;
+  return 0;
+}
+
 pn_link_t *pn_messenger_source(pn_messenger_t *messenger, const char *source,
                                pn_seconds_t timeout)
 {
@@ -1812,6 +2481,30 @@ int pn_messenger_set_outgoing_window(pn_messenger_t *messenger, int window)
   return 0;
 }
 
+int pn_messenger_get_outgoing_limit(pn_messenger_t *messenger)
+{
+  return messenger->outgoing_limit;
+}
+
+int pn_messenger_set_outgoing_limit(pn_messenger_t *messenger, int limit)
+{
+  if (!messenger || limit < 0) return PN_ARG_ERR;
+  messenger->outgoing_limit = limit;
+  return 0;
+}
+
+size_t pn_messenger_get_outgoing_byte_limit(pn_messenger_t *messenger)
+{
+  return messenger->outgoing_byte_limit;
+}
+
+int pn_messenger_set_outgoing_byte_limit(pn_messenger_t *messenger, size_t limit)
+{
+  if (!messenger) return PN_ARG_ERR;
+  messenger->outgoing_byte_limit = limit;
+  return 0;
+}
+
 int pn_messenger_get_incoming_window(pn_messenger_t *messenger)
 {
   return pni_store_get_window(messenger->incoming);
@@ -1823,6 +2516,30 @@ int pn_messenger_set_incoming_window(pn_messenger_t *messenger, int window)
   return 0;
 }
 
+int pn_messenger_get_accept_batch(pn_messenger_t *messenger)
+{
+  return messenger->accept_batch;
+}
+
+int pn_messenger_set_accept_batch(pn_messenger_t *messenger, int batch)
+{
+  if (batch < 1) return PN_ARG_ERR;
+  messenger->accept_batch = batch;
+  return 0;
+}
+
+int pn_messenger_get_spin(pn_messenger_t *messenger)
+{
+  return pn_selector_get_spin(messenger->selector);
+}
+
+int pn_messenger_set_spin(pn_messenger_t *messenger, int usecs)
+{
+  if (usecs < 0) return PN_ARG_ERR;
+  pn_selector_set_spin(messenger->selector, usecs);
+  return 0;
+}
+
 static void outward_munge(pn_messenger_t *mng, pn_message_t *msg)
 {
   char stackbuf[256];
@@ -1860,9 +2577,29 @@ int pni_bump_out(pn_messenger_t *messenger, const char *address)
   return 0;
 }
 
+// Messages for a striped address queue on the link picked for them, so
+// they only ever go out on that link; others queue under their address.
+static pni_entry_t *pni_outgoing_head(pn_messenger_t *messenger, const char *address,
+                                      pn_link_t *sender)
+{
+  pn_link_ctx_t *ctx = (pn_link_ctx_t *) pn_link_get_context(sender);
+  if (ctx && ctx->striped) {
+    return pni_store_get_keyed(messenger->outgoing, sender);
+  } else {
+    return pni_store_get(messenger->outgoing, address);
+  }
+}
+
 int pni_pump_out(pn_messenger_t *messenger, const char *address, pn_link_t *sender)
 {
-  pni_entry_t *entry = pni_store_get(messenger->outgoing, address);
+  pni_entry_t *entry = pni_outgoing_head(messenger, address, sender);
+  // don't spend credit or bandwidth on messages that expired while queued
+  while (entry && pni_entry_expired(entry, messenger->now)) {
+    pni_entry_set_status(entry, PN_STATUS_ABORTED);
+    pni_entry_notify(messenger, entry);
+    pni_entry_free(entry);
+    entry = pni_outgoing_head(messenger, address, sender);
+  }
   if (!entry) {
     pn_link_drained(sender);
     return 0;
@@ -1880,6 +2617,11 @@ int pni_pump_out(pn_messenger_t *messenger, const char *address, pn_link_t *send
   *((uint64_t *) ptr) = next;
   pn_delivery_t *d = pn_delivery(sender, pn_dtag(tag, 8));
   pni_entry_set_delivery(entry, d);
+  pn_timestamp_t expiry = pni_entry_get_expiry(entry);
+  if (expiry) {
+    messenger->next_expiry = messenger->next_expiry ?
+      pn_min(messenger->next_expiry, expiry) : expiry;
+  }
   ssize_t n = pn_link_send(sender, encoded, size);
   if (n < 0) {
     pni_entry_free(entry);
@@ -1888,6 +2630,7 @@ int pni_pump_out(pn_messenger_t *messenger, const char *address, pn_link_t *send
   } else {
     pn_link_advance(sender);
     pni_entry_free(entry);
+    pni_sender_account(messenger, sender);
     return 0;
   }
 }
@@ -1934,17 +2677,66 @@ static void pni_restore(pn_messenger_t *messenger, pn_message_t *msg)
   pn_message_set_address(msg, pn_string_get(messenger->original));
 }
 
-int pn_messenger_put(pn_messenger_t *messenger, pn_message_t *msg)
+// Outgoing messages count against the limits until they are written to
+// the transport, whether they are still in the store or buffered on a
+// link waiting for credit. The link side is kept as running totals by
+// pni_sender_account.
+static bool pni_outgoing_room(pn_messenger_t *messenger)
+{
+  if (messenger->outgoing_limit &&
+      (int) pni_store_size(messenger->outgoing) + messenger->outgoing_queued >=
+      messenger->outgoing_limit) {
+    return false;
+  }
+
+  if (messenger->outgoing_byte_limit &&
+      pni_store_bytes(messenger->outgoing) + messenger->outgoing_bytes >=
+      messenger->outgoing_byte_limit) {
+    return false;
+  }
+
+  return true;
+}
+
+// Work out when a message expires from its absolute expiry time, or
+// failing that its ttl, so the store never has to decode it again.
+// The result is on the monotonic clock; the wall clock expiry time the
+// protocol carries is moved onto it with the messenger's epoch.
+static pn_timestamp_t pni_message_expiry(pn_messenger_t *messenger, pn_message_t *msg)
+{
+  pn_timestamp_t expiry = pn_message_get_expiry_time(msg);
+  pn_millis_t ttl = pn_message_get_ttl(msg);
+  if (!expiry && !ttl) return 0;
+
+  pn_timestamp_t now = pni_messenger_now(messenger);
+  if (expiry) {
+    return pn_max(expiry - messenger->epoch, now);
+  }
+  return now + ttl;
+}
+
+static int pni_put(pn_messenger_t *messenger, pn_message_t *msg,
+                   pn_tracker_callback_t callback, void *context)
 {
   if (!messenger) return PN_ARG_ERR;
   if (!msg) return pn_error_set(messenger->error, PN_ARG_ERR, "null message");
+  if (!pni_outgoing_room(messenger)) {
+    int err = pn_messenger_sync(messenger, pni_outgoing_room);
+    if (err) return pn_error_format(messenger->error, err, "outgoing limit reached");
+  }
   outward_munge(messenger, msg);
   const char *address = pn_message_get_address(msg);
 
-  pni_entry_t *entry = pni_store_put(messenger->outgoing, address);
+  bool striped = false;
+  pn_link_t *sender = pni_target(messenger, address, msg, &striped);
+  pni_entry_t *entry = striped && sender
+    ? pni_store_put_keyed(messenger->outgoing, sender)
+    : pni_store_put(messenger->outgoing, address);
   if (!entry)
     return pn_error_format(messenger->error, PN_ERR, "store error");
 
+  pni_entry_set_callback(entry, callback, context);
+  pni_entry_set_expiry(entry, pni_message_expiry(messenger, msg));
   messenger->outgoing_tracker = pn_tracker(OUTGOING, pni_entry_track(entry));
   pn_buffer_t *buf = pni_entry_bytes(entry);
 
@@ -1966,8 +2758,7 @@ int pn_messenger_put(pn_messenger_t *messenger, pn_message_t *msg)
                              pn_message_error(msg));
     } else {
       pni_restore(messenger, msg);
-      pn_buffer_append(buf, encoded, size); // XXX
-      pn_link_t *sender = pn_messenger_target(messenger, address, 0);
+      pni_entry_append(entry, encoded, size); // XXX
       if (!sender) {
         int err = pn_error_code(messenger->error);
         if (err) {
@@ -1986,6 +2777,27 @@ int pn_messenger_put(pn_messenger_t *messenger, pn_message_t *msg)
   return PN_ERR;
 }
 
+int pn_messenger_put(pn_messenger_t *messenger, pn_message_t *msg)
+{
+  return pni_put(messenger, msg, NULL, NULL);
+}
+
+int pn_messenger_put_callback(pn_messenger_t *messenger, pn_message_t *msg,
+                              pn_tracker_callback_t callback, void *context)
+{
+  return pni_put(messenger, msg, callback, context);
+}
+
+int pn_messenger_set_tracker_callback(pn_messenger_t *messenger,
+                                      pn_tracker_callback_t callback,
+                                      void *context)
+{
+  if (!messenger) return PN_ARG_ERR;
+  messenger->callback = callback;
+  messenger->callback_context = context;
+  return 0;
+}
+
 pn_tracker_t pn_messenger_outgoing_tracker(pn_messenger_t *messenger)
 {
   assert(messenger);
@@ -2196,11 +3008,41 @@ int pn_messenger_receiving(pn_messenger_t *messenger)
   return messenger->credit + messenger->distributed;
 }
 
-int pn_messenger_get(pn_messenger_t *messenger, pn_message_t *msg)
+// the incoming rotation has a slot per subscription plus a last one,
+// holding no subscription, for messages that arrived without one
+static pn_subscription_t *pni_incoming_slot(pn_messenger_t *messenger, size_t slot)
 {
-  if (!messenger) return PN_ARG_ERR;
+  if (slot < pn_list_size(messenger->subscriptions)) {
+    return (pn_subscription_t *) pn_list_get(messenger->subscriptions, slot);
+  } else {
+    return NULL;
+  }
+}
 
-  pni_entry_t *entry = pni_store_get(messenger->incoming, NULL);
+// pick the next incoming entry, visiting the slots in turn and taking
+// up to their weight in messages from each
+static pni_entry_t *pni_next_incoming(pn_messenger_t *messenger)
+{
+  size_t slots = pn_list_size(messenger->subscriptions) + 1;
+  for (size_t i = 0; i <= slots; i++) {
+    messenger->next_subscription %= slots;
+    pn_subscription_t *sub = pni_incoming_slot(messenger, messenger->next_subscription);
+    int weight = sub ? pn_subscription_get_weight(sub) : 1;
+    pni_entry_t *entry = pni_store_get_keyed(messenger->incoming, sub);
+    if (entry && messenger->served < weight) {
+      messenger->served++;
+      return entry;
+    }
+
+    messenger->next_subscription++;
+    messenger->served = 0;
+  }
+
+  return NULL;
+}
+
+static int pni_get(pn_messenger_t *messenger, pni_entry_t *entry, pn_message_t *msg)
+{
   // XXX: need to drain credit before returning EOS
   if (!entry) return PN_EOS;
 
@@ -2227,6 +3069,20 @@ int pn_messenger_get(pn_messenger_t *messenger, pn_message_t *msg)
   }
 }
 
+int pn_messenger_get(pn_messenger_t *messenger, pn_message_t *msg)
+{
+  if (!messenger) return PN_ARG_ERR;
+  if (!pni_store_size(messenger->incoming)) return PN_EOS;
+  return pni_get(messenger, pni_next_incoming(messenger), msg);
+}
+
+int pn_messenger_get_from(pn_messenger_t *messenger, pn_subscription_t *sub,
+                          pn_message_t *msg)
+{
+  if (!messenger || !sub) return PN_ARG_ERR;
+  return pni_get(messenger, pni_store_get_keyed(messenger->incoming, sub), msg);
+}
+
 pn_tracker_t pn_messenger_incoming_tracker(pn_messenger_t *messenger)
 {
   assert(messenger);
@@ -2387,6 +3243,7 @@ pn_millis_t pn_messenger_get_remote_idle_timeout(pn_messenger_t *messenger,
       break;
     }
   }
+  pn_free(addr.text);
   return timeout;
 }
 
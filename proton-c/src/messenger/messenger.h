@@ -26,5 +26,6 @@
 
 int pni_messenger_add_subscription(pn_messenger_t *messenger, pn_subscription_t *subscription);
 int pni_messenger_work(pn_messenger_t *messenger);
+pn_link_t *pni_messenger_warm_link(pn_messenger_t *messenger, const char *address);
 
 #endif /* messenger.h */
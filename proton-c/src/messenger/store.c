@@ -37,8 +37,11 @@ struct pni_store_t {
   pni_stream_t *streams;
   pni_entry_t *store_head;
   pni_entry_t *store_tail;
+  pni_entry_t *tracked_head;
+  pni_entry_t *tracked_tail;
   pn_hash_t *tracked;
   size_t size;
+  size_t bytes;  // encoded size of all entries
   int window;
   pn_sequence_t lwm;
   pn_sequence_t hwm;
@@ -46,7 +49,8 @@ struct pni_store_t {
 
 struct pni_stream_t {
   pni_store_t *store;
-  pn_string_t *address;
+  pn_string_t *address;  // NULL for keyed streams
+  void *key;
   pni_entry_t *stream_head;
   pni_entry_t *stream_tail;
   pni_stream_t *next;
@@ -58,9 +62,14 @@ struct pni_entry_t {
   pni_entry_t *stream_prev;
   pni_entry_t *store_next;
   pni_entry_t *store_prev;
+  pni_entry_t *tracked_next;
+  pni_entry_t *tracked_prev;
   pn_buffer_t *bytes;
   pn_delivery_t *delivery;
   void *context;
+  pn_tracker_callback_t callback;
+  void *callback_context;
+  pn_timestamp_t expiry;
   pn_status_t status;
   pn_sequence_t id;
   bool free;
@@ -83,9 +92,12 @@ pni_store_t *pni_store()
   if (!store) return NULL;
 
   store->size = 0;
+  store->bytes = 0;
   store->streams = NULL;
   store->store_head = NULL;
   store->store_tail = NULL;
+  store->tracked_head = NULL;
+  store->tracked_tail = NULL;
   store->window = 0;
   store->lwm = 0;
   store->hwm = 0;
@@ -100,15 +112,24 @@ size_t pni_store_size(pni_store_t *store)
   return store->size;
 }
 
-pni_stream_t *pni_stream(pni_store_t *store, const char *address, bool create)
+size_t pni_store_bytes(pni_store_t *store)
+{
+  assert(store);
+  return store->bytes;
+}
+
+// streams are identified either by address or, when address is NULL,
+// by an opaque key
+pni_stream_t *pni_stream(pni_store_t *store, const char *address, void *key, bool create)
 {
   assert(store);
-  assert(address);
 
   pni_stream_t *prev = NULL;
   pni_stream_t *stream = store->streams;
   while (stream) {
-    if (!strcmp(pn_string_get(stream->address), address)) {
+    if (address
+        ? stream->address && !strcmp(pn_string_get(stream->address), address)
+        : !stream->address && stream->key == key) {
       return stream;
     }
     prev = stream;
@@ -118,7 +139,8 @@ pni_stream_t *pni_stream(pni_store_t *store, const char *address, bool create)
   if (create) {
     stream = (pni_stream_t *) malloc(sizeof(pni_stream_t));
     stream->store = store;
-    stream->address = pn_string(address);
+    stream->address = address ? pn_string(address) : NULL;
+    stream->key = address ? NULL : key;
     stream->stream_head = NULL;
     stream->stream_tail = NULL;
     stream->next = NULL;
@@ -154,6 +176,7 @@ void pni_entry_free(pni_entry_t *entry)
   LL_REMOVE(store, store, entry);
   entry->free = true;
 
+  store->bytes -= pn_buffer_size(entry->bytes);
   pn_buffer_free(entry->bytes);
   entry->bytes = NULL;
   pn_decref(entry);
@@ -188,13 +211,13 @@ void pni_store_free(pni_store_t *store)
 pni_stream_t *pni_stream_put(pni_store_t *store, const char *address)
 {
   assert(store); assert(address);
-  return pni_stream(store, address, true);
+  return pni_stream(store, address, NULL, true);
 }
 
 pni_stream_t *pni_stream_get(pni_store_t *store, const char *address)
 {
   assert(store); assert(address);
-  return pni_stream(store, address, false);
+  return pni_stream(store, address, NULL, false);
 }
 
 #define CID_pni_entry CID_pn_object
@@ -203,14 +226,12 @@ pni_stream_t *pni_stream_get(pni_store_t *store, const char *address)
 #define pni_entry_compare NULL
 #define pni_entry_inspect NULL
 
-pni_entry_t *pni_store_put(pni_store_t *store, const char *address)
+static pni_entry_t *pni_stream_add(pni_stream_t *stream)
 {
-  assert(store);
   static const pn_class_t clazz = PN_CLASS(pni_entry);
 
-  if (!address) address = "";
-  pni_stream_t *stream = pni_stream_put(store, address);
   if (!stream) return NULL;
+  pni_store_t *store = stream->store;
   pni_entry_t *entry = (pni_entry_t *) pn_class_new(&clazz, sizeof(pni_entry_t));
   if (!entry) return NULL;
   entry->stream = stream;
@@ -219,7 +240,13 @@ pni_entry_t *pni_store_put(pni_store_t *store, const char *address)
   entry->stream_prev = NULL;
   entry->store_next = NULL;
   entry->store_prev = NULL;
+  entry->tracked_next = NULL;
+  entry->tracked_prev = NULL;
   entry->delivery = NULL;
+  entry->context = NULL;
+  entry->callback = NULL;
+  entry->callback_context = NULL;
+  entry->expiry = 0;
   entry->bytes = pn_buffer(64);
   entry->status = PN_STATUS_UNKNOWN;
   LL_ADD(stream, stream, entry);
@@ -228,6 +255,26 @@ pni_entry_t *pni_store_put(pni_store_t *store, const char *address)
   return entry;
 }
 
+pni_entry_t *pni_store_put(pni_store_t *store, const char *address)
+{
+  assert(store);
+  if (!address) address = "";
+  return pni_stream_add(pni_stream_put(store, address));
+}
+
+pni_entry_t *pni_store_put_keyed(pni_store_t *store, void *key)
+{
+  assert(store);
+  return pni_stream_add(pni_stream(store, NULL, key, true));
+}
+
+pni_entry_t *pni_store_get_keyed(pni_store_t *store, void *key)
+{
+  assert(store);
+  pni_stream_t *stream = pni_stream(store, NULL, key, false);
+  return stream ? LL_HEAD(stream, stream) : NULL;
+}
+
 pni_entry_t *pni_store_get(pni_store_t *store, const char *address)
 {
   assert(store);
@@ -246,6 +293,14 @@ pn_buffer_t *pni_entry_bytes(pni_entry_t *entry)
   return entry->bytes;
 }
 
+int pni_entry_append(pni_entry_t *entry, const char *bytes, size_t size)
+{
+  assert(entry);
+  int err = pn_buffer_append(entry->bytes, bytes, size);
+  if (!err) entry->stream->store->bytes += size;
+  return err;
+}
+
 pn_status_t pni_entry_get_status(pni_entry_t *entry)
 {
   assert(entry);
@@ -289,6 +344,45 @@ void *pni_entry_get_context(pni_entry_t *entry)
   return entry->context;
 }
 
+void pni_entry_set_callback(pni_entry_t *entry, pn_tracker_callback_t callback,
+                            void *context)
+{
+  assert(entry);
+  entry->callback = callback;
+  entry->callback_context = context;
+}
+
+pn_tracker_callback_t pni_entry_get_callback(pni_entry_t *entry)
+{
+  assert(entry);
+  return entry->callback;
+}
+
+void *pni_entry_get_callback_context(pni_entry_t *entry)
+{
+  assert(entry);
+  return entry->callback_context;
+}
+
+pn_timestamp_t pni_entry_get_expiry(pni_entry_t *entry)
+{
+  assert(entry);
+  return entry->expiry;
+}
+
+void pni_entry_set_expiry(pni_entry_t *entry, pn_timestamp_t expiry)
+{
+  assert(entry);
+  entry->expiry = expiry;
+}
+
+// an expiry of zero means the entry never expires
+bool pni_entry_expired(pni_entry_t *entry, pn_timestamp_t now)
+{
+  assert(entry);
+  return entry->expiry && entry->expiry <= now;
+}
+
 static pn_status_t disp2status(uint64_t disp)
 {
   if (!disp) return PN_STATUS_PENDING;
@@ -349,6 +443,18 @@ bool pni_store_tracking(pni_store_t *store, pn_sequence_t id)
   return (id - store->lwm >= 0) && (store->hwm - id > 0);
 }
 
+// Tracked entries are kept both in the hash, for lookup by id, and on
+// a list in id order. Ids are handed out in increasing order so new
+// entries always go on the tail, and the head is always the lowest
+// tracked id. This lets window eviction and cumulative updates visit
+// only the entries that are still tracked rather than every id in
+// the window.
+static void pni_store_untrack(pni_store_t *store, pni_entry_t *entry)
+{
+  LL_REMOVE(store, tracked, entry);
+  pn_hash_del(store->tracked, entry->id);
+}
+
 pn_sequence_t pni_entry_track(pni_entry_t *entry)
 {
   assert(entry);
@@ -356,14 +462,13 @@ pn_sequence_t pni_entry_track(pni_entry_t *entry)
   pni_store_t *store = entry->stream->store;
   entry->id = store->hwm++;
   pn_hash_put(store->tracked, entry->id, entry);
+  LL_ADD(store, tracked, entry);
 
-  if (store->window >= 0) {
-    while (store->hwm - store->lwm > store->window) {
-      pni_entry_t *e = pni_store_entry(store, store->lwm);
-      if (e) {
-        pn_hash_del(store->tracked, store->lwm);
-      }
-      store->lwm++;
+  if (store->window >= 0 && store->hwm - store->lwm > store->window) {
+    store->lwm = store->hwm - store->window;
+    pni_entry_t *e;
+    while ((e = LL_HEAD(store, tracked)) && e->id - store->lwm < 0) {
+      pni_store_untrack(store, e);
     }
   }
 
@@ -379,50 +484,47 @@ int pni_store_update(pni_store_t *store, pn_sequence_t id, pn_status_t status,
     return 0;
   }
 
-  size_t start;
+  pni_entry_t *e;
+  pni_entry_t *next;
   if (PN_CUMULATIVE & flags) {
-    start = store->lwm;
+    e = LL_HEAD(store, tracked);
   } else {
-    start = id;
+    e = pni_store_entry(store, id);
   }
 
-  for (pn_sequence_t i = start; i <= id; i++) {
-    pni_entry_t *e = pni_store_entry(store, i);
-    if (e) {
-      pn_delivery_t *d = e->delivery;
-      if (d) {
-        if (!pn_delivery_local_state(d)) {
-          if (match) {
-            pn_delivery_update(d, pn_delivery_remote_state(d));
-          } else {
-            switch (status) {
-            case PN_STATUS_ACCEPTED:
-              pn_delivery_update(d, PN_ACCEPTED);
-              break;
-            case PN_STATUS_REJECTED:
-              pn_delivery_update(d, PN_REJECTED);
-              break;
-            default:
-              break;
-            }
+  for (; e && e->id - id <= 0; e = next) {
+    next = (PN_CUMULATIVE & flags) ? e->tracked_next : NULL;
+    pn_delivery_t *d = e->delivery;
+    if (d) {
+      if (!pn_delivery_local_state(d)) {
+        if (match) {
+          pn_delivery_update(d, pn_delivery_remote_state(d));
+        } else {
+          switch (status) {
+          case PN_STATUS_ACCEPTED:
+            pn_delivery_update(d, PN_ACCEPTED);
+            break;
+          case PN_STATUS_REJECTED:
+            pn_delivery_update(d, PN_REJECTED);
+            break;
+          default:
+            break;
           }
-
-          pni_entry_updated(e);
         }
+
+        pni_entry_updated(e);
       }
-      if (settle) {
-        if (d) {
-          pn_delivery_settle(d);
-        }
-        pn_hash_del(store->tracked, e->id);
+    }
+    if (settle) {
+      if (d) {
+        pn_delivery_settle(d);
       }
+      pni_store_untrack(store, e);
     }
   }
 
-  while (store->hwm - store->lwm > 0 &&
-         !pn_hash_get(store->tracked, store->lwm)) {
-    store->lwm++;
-  }
+  e = LL_HEAD(store, tracked);
+  store->lwm = e ? e->id : store->hwm;
 
   return 0;
 }
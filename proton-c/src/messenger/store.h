@@ -30,20 +30,32 @@ typedef struct pni_entry_t pni_entry_t;
 pni_store_t *pni_store(void);
 void pni_store_free(pni_store_t *store);
 size_t pni_store_size(pni_store_t *store);
+size_t pni_store_bytes(pni_store_t *store);
 pni_entry_t *pni_store_put(pni_store_t *store, const char *address);
 pni_entry_t *pni_store_get(pni_store_t *store, const char *address);
+pni_entry_t *pni_store_put_keyed(pni_store_t *store, void *key);
+pni_entry_t *pni_store_get_keyed(pni_store_t *store, void *key);
 
 pn_buffer_t *pni_entry_bytes(pni_entry_t *entry);
+int pni_entry_append(pni_entry_t *entry, const char *bytes, size_t size);
 pn_status_t pni_entry_get_status(pni_entry_t *entry);
 void pni_entry_set_status(pni_entry_t *entry, pn_status_t status);
 pn_delivery_t *pni_entry_get_delivery(pni_entry_t *entry);
 void pni_entry_set_delivery(pni_entry_t *entry, pn_delivery_t *delivery);
 void pni_entry_set_context(pni_entry_t *entry, void *context);
 void *pni_entry_get_context(pni_entry_t *entry);
+void pni_entry_set_callback(pni_entry_t *entry, pn_tracker_callback_t callback,
+                            void *context);
+pn_tracker_callback_t pni_entry_get_callback(pni_entry_t *entry);
+void *pni_entry_get_callback_context(pni_entry_t *entry);
+pn_timestamp_t pni_entry_get_expiry(pni_entry_t *entry);
+void pni_entry_set_expiry(pni_entry_t *entry, pn_timestamp_t expiry);
+bool pni_entry_expired(pni_entry_t *entry, pn_timestamp_t now);
 void pni_entry_updated(pni_entry_t *entry);
 void pni_entry_free(pni_entry_t *entry);
 
 pn_sequence_t pni_entry_track(pni_entry_t *entry);
+pn_sequence_t pni_entry_id(pni_entry_t *entry);
 pni_entry_t *pni_store_entry(pni_store_t *store, pn_sequence_t id);
 int pni_store_update(pni_store_t *store, pn_sequence_t id, pn_status_t status,
                      int flags, bool settle, bool match);
@@ -236,6 +236,12 @@ int pn_transform_apply(pn_transform_t *transform, const char *src,
   return pn_string_set(dst, src);
 }
 
+bool pn_transform_match(const char *pattern, const char *src)
+{
+  pn_matcher_t matcher;
+  return pni_match(&matcher, pattern, src);
+}
+
 bool pn_transform_matched(pn_transform_t *transform)
 {
   return transform->matched;
@@ -35,5 +35,6 @@ int pn_transform_apply(pn_transform_t *transform, const char *src,
 bool pn_transform_matched(pn_transform_t *transform);
 int pn_transform_get_substitutions(pn_transform_t *transform,
                                    pn_list_t *substitutions);
+bool pn_transform_match(const char *pattern, const char *src);
 
 #endif /* transform.h */
@@ -31,6 +31,13 @@ pn_timestamp_t pn_i_now(void)
   if (clock_gettime(CLOCK_REALTIME, &now)) pni_fatal("clock_gettime() failed\n");
   return ((pn_timestamp_t)now.tv_sec) * 1000 + (now.tv_nsec / 1000000);
 }
+
+pn_timestamp_t pn_i_monotonic_us(void)
+{
+  struct timespec now;
+  if (clock_gettime(CLOCK_MONOTONIC, &now)) pni_fatal("clock_gettime() failed\n");
+  return ((pn_timestamp_t)now.tv_sec) * 1000000 + (now.tv_nsec / 1000);
+}
 #elif defined(USE_WIN_FILETIME)
 #include <windows.h>
 pn_timestamp_t pn_i_now(void)
@@ -43,6 +50,15 @@ pn_timestamp_t pn_i_now(void)
   // Convert to milliseconds and adjust base epoch
   return t.QuadPart / 10000 - 11644473600000;
 }
+
+pn_timestamp_t pn_i_monotonic_us(void)
+{
+  LARGE_INTEGER freq, now;
+  QueryPerformanceFrequency(&freq);
+  QueryPerformanceCounter(&now);
+  return (now.QuadPart / freq.QuadPart) * 1000000 +
+    (now.QuadPart % freq.QuadPart) * 1000000 / freq.QuadPart;
+}
 #else
 #include <sys/time.h>
 pn_timestamp_t pn_i_now(void)
@@ -51,8 +67,25 @@ pn_timestamp_t pn_i_now(void)
   if (gettimeofday(&now, NULL)) pni_fatal("gettimeofday failed\n");
   return ((pn_timestamp_t)now.tv_sec) * 1000 + (now.tv_usec / 1000);
 }
+
+pn_timestamp_t pn_i_monotonic_us(void)
+{
+  struct timeval now;
+  if (gettimeofday(&now, NULL)) pni_fatal("gettimeofday failed\n");
+  return ((pn_timestamp_t)now.tv_sec) * 1000000 + now.tv_usec;
+}
 #endif
 
+pn_timestamp_t pn_i_monotonic_ms(void)
+{
+  return pn_i_monotonic_us() / 1000;
+}
+
+pn_timestamp_t pn_i_monotonic_epoch(void)
+{
+  return pn_i_now() - pn_i_monotonic_ms();
+}
+
 #ifdef USE_UUID_GENERATE
 #include <uuid/uuid.h>
 #include <stdlib.h>
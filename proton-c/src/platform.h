@@ -39,6 +39,38 @@ extern "C" {
  */
 pn_timestamp_t pn_i_now(void);
 
+/** Get a monotonic time in microseconds.
+ *
+ * The value has no defined epoch and is only meaningful when compared
+ * with other values returned by this function. Where no monotonic
+ * clock is available the wall clock is used instead.
+ *
+ * @return monotonic time in microseconds
+ * @internal
+ */
+pn_timestamp_t pn_i_monotonic_us(void);
+
+/** Get a monotonic time in milliseconds.
+ *
+ * This is the clock used for internal deadlines, such as selectable
+ * and transport tick deadlines. Unlike ::pn_i_now it does not jump
+ * when the wall clock is adjusted.
+ *
+ * @return monotonic time in milliseconds
+ * @internal
+ */
+pn_timestamp_t pn_i_monotonic_ms(void);
+
+/** Get the wall clock time at which the monotonic clock read zero.
+ *
+ * Adding this to a value from ::pn_i_monotonic_ms converts it to
+ * milliseconds since the Unix Epoch, as returned by ::pn_i_now.
+ *
+ * @return the offset of the monotonic clock from the wall clock
+ * @internal
+ */
+pn_timestamp_t pn_i_monotonic_epoch(void);
+
 /** Generate a UUID in string format.
  *
  * Returns a newly generated UUID in the standard 36 char format.
@@ -46,6 +46,9 @@
 #define PN_SEL_RD (0x0001)
 #define PN_SEL_WR (0x0002)
 
+// maximum connections handed out by pn_listener_accept per wakeup
+#define PN_ACCEPT_BATCH (16)
+
 struct pn_driver_t {
   pn_error_t *error;
   pn_io_t *io;
@@ -64,8 +67,14 @@ struct pn_driver_t {
   int ctrl[2]; //pipe for updating selectable status
   pn_timestamp_t wakeup;
   pn_trace_t trace;
+  uint64_t spins;
+  uint64_t blocks;
+  int spin;
+  int busy_poll;
 };
 
+#define PN_NAME_MAX (256)
+
 struct pn_listener_t {
   pn_driver_t *driver;
   pn_listener_t *listener_next;
@@ -73,12 +82,13 @@ struct pn_listener_t {
   void *context;
   int idx;
   int fd;
+  int accepted;
   bool pending;
   bool closed;
+  pn_socket_t ahead;  // connection accepted ahead of the next pn_listener_accept
+  char ahead_name[PN_NAME_MAX];
 };
 
-#define PN_NAME_MAX (256)
-
 struct pn_connector_t {
   pn_driver_t *driver;
   pn_connector_t *connector_next;
@@ -104,6 +114,15 @@ struct pn_connector_t {
 
 /* Impls */
 
+static void pn_driver_busy_poll(int fd, int usecs)
+{
+#ifdef SO_BUSY_POLL
+  // raising the value above the system default may need privileges,
+  // in which case the socket is simply left as it was
+  setsockopt(fd, SOL_SOCKET, SO_BUSY_POLL, &usecs, sizeof(usecs));
+#endif
+}
+
 // listener
 
 static void pn_driver_add_listener(pn_driver_t *d, pn_listener_t *l)
@@ -155,11 +174,20 @@ pn_listener_t *pn_listener_fd(pn_driver_t *driver, int fd, void *context)
   l->listener_next = NULL;
   l->listener_prev = NULL;
   l->idx = 0;
+  l->accepted = 0;
   l->pending = false;
+  l->ahead = PN_INVALID_SOCKET;
   l->fd = fd;
   l->closed = false;
   l->context = context;
 
+  // accepting is done in batches until the backlog drains, which
+  // requires a non-blocking listener
+  int flags = fcntl(fd, F_GETFL);
+  if (flags >= 0 && !(flags & O_NONBLOCK)) {
+    fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+  }
+
   pn_driver_add_listener(driver, l);
   return l;
 }
@@ -199,8 +227,16 @@ pn_connector_t *pn_listener_accept(pn_listener_t *l)
   if (!l || !l->pending) return NULL;
   char name[PN_NAME_MAX];
 
-  pn_socket_t sock = pn_accept(l->driver->io, l->fd, name, PN_NAME_MAX);
+  pn_socket_t sock = l->ahead;
+  if (sock != PN_INVALID_SOCKET) {
+    snprintf(name, PN_NAME_MAX, "%s", l->ahead_name);
+    l->ahead = PN_INVALID_SOCKET;
+  } else {
+    sock = pn_accept(l->driver->io, l->fd, name, PN_NAME_MAX);
+  }
+
   if (sock == PN_INVALID_SOCKET) {
+    l->pending = false;
     return NULL;
   } else {
     if (l->driver->trace & (PN_TRACE_FRM | PN_TRACE_RAW | PN_TRACE_DRV))
@@ -208,6 +244,19 @@ pn_connector_t *pn_listener_accept(pn_listener_t *l)
     pn_connector_t *c = pn_connector_fd(l->driver, sock, NULL);
     snprintf(c->name, PN_NAME_MAX, "%s", name);
     c->listener = l;
+
+    // so that a burst of connections does not need a poll cycle per
+    // connection, accept the next one now and, if there is one, offer
+    // this listener again from pn_driver_listener until the batch is
+    // used up; a listener is only ever offered with a connection ready
+    l->pending = false;
+    if (++l->accepted < PN_ACCEPT_BATCH) {
+      l->ahead = pn_accept(l->driver->io, l->fd, l->ahead_name, PN_NAME_MAX);
+      if (l->ahead != PN_INVALID_SOCKET) {
+        l->pending = true;
+        l->driver->listener_next = l;
+      }
+    }
     return c;
   }
 }
@@ -219,6 +268,10 @@ void pn_listener_close(pn_listener_t *l)
 
   if (close(l->fd) == -1)
     perror("close");
+  if (l->ahead != PN_INVALID_SOCKET) {
+    close(l->ahead);
+    l->ahead = PN_INVALID_SOCKET;
+  }
   l->closed = true;
 }
 
@@ -227,6 +280,7 @@ void pn_listener_free(pn_listener_t *l)
   if (!l) return;
 
   if (l->driver) pn_driver_remove_listener(l->driver, l);
+  if (l->ahead != PN_INVALID_SOCKET) close(l->ahead);
   free(l);
 }
 
@@ -297,6 +351,7 @@ pn_connector_t *pn_connector_fd(pn_driver_t *driver, int fd, void *context)
   c->context = context;
   c->listener = NULL;
 
+  if (driver->busy_poll) pn_driver_busy_poll(fd, driver->busy_poll);
   pn_connector_trace(c, driver->trace);
 
   pn_driver_add_connector(driver, c);
@@ -496,7 +551,7 @@ void pn_connector_process(pn_connector_t *c)
     ///
     /// Event wakeup
     ///
-    c->wakeup = pn_connector_tick(c, pn_i_now());
+    c->wakeup = pn_connector_tick(c, pn_i_monotonic_ms());
 
     ///
     /// Socket write
@@ -565,6 +620,10 @@ pn_driver_t *pn_driver()
               (pn_env_bool("PN_TRACE_FRM") ? PN_TRACE_FRM : PN_TRACE_OFF) |
               (pn_env_bool("PN_TRACE_DRV") ? PN_TRACE_DRV : PN_TRACE_OFF));
   d->wakeup = 0;
+  d->spins = 0;
+  d->blocks = 0;
+  d->spin = 0;
+  d->busy_poll = 0;
 
   // XXX
   if (pipe(d->ctrl)) {
@@ -591,6 +650,39 @@ void pn_driver_trace(pn_driver_t *d, pn_trace_t trace)
   d->trace = trace;
 }
 
+void pn_driver_set_spin(pn_driver_t *d, int usecs)
+{
+  assert(d);
+  d->spin = usecs > 0 ? usecs : 0;
+}
+
+int pn_driver_get_spin(pn_driver_t *d)
+{
+  assert(d);
+  return d->spin;
+}
+
+void pn_driver_set_busy_poll(pn_driver_t *d, int usecs)
+{
+  assert(d);
+  d->busy_poll = usecs > 0 ? usecs : 0;
+  for (pn_connector_t *c = d->connector_head; c; c = c->connector_next) {
+    if (!c->closed) pn_driver_busy_poll(c->fd, d->busy_poll);
+  }
+}
+
+uint64_t pn_driver_spins(pn_driver_t *d)
+{
+  assert(d);
+  return d->spins;
+}
+
+uint64_t pn_driver_blocks(pn_driver_t *d)
+{
+  assert(d);
+  return d->blocks;
+}
+
 void pn_driver_free(pn_driver_t *d)
 {
   if (!d) return;
@@ -670,13 +762,40 @@ void pn_driver_wait_1(pn_driver_t *d)
 int pn_driver_wait_2(pn_driver_t *d, int timeout)
 {
   if (d->wakeup) {
-    pn_timestamp_t now = pn_i_now();
+    pn_timestamp_t now = pn_i_monotonic_ms();
     if (now >= d->wakeup)
       timeout = 0;
     else
       timeout = (timeout < 0) ? d->wakeup-now : pn_min(timeout, d->wakeup - now);
   }
-  int result = poll(d->fds, d->nfds, d->closed_count > 0 ? 0 : timeout);
+  if (d->closed_count > 0) timeout = 0;
+  // a connection accepted ahead is ready whatever poll says
+  for (pn_listener_t *l = d->listener_head; l; l = l->listener_next) {
+    if (l->ahead != PN_INVALID_SOCKET) timeout = 0;
+  }
+
+  int result;
+  if (d->spin && timeout) {
+    // poll without blocking for the spin period before falling back
+    // to a blocking poll for the remainder of the timeout
+    pn_timestamp_t start = pn_i_monotonic_us();
+    pn_timestamp_t elapsed = 0;
+    while (!(result = poll(d->fds, d->nfds, 0)) && elapsed < d->spin &&
+           (timeout < 0 || elapsed < (pn_timestamp_t) timeout*1000)) {
+      elapsed = pn_i_monotonic_us() - start;
+    }
+    if (!result) {
+      if (timeout > 0) {
+        timeout = elapsed/1000 < timeout ? timeout - elapsed/1000 : 0;
+      }
+      d->blocks++;
+      result = poll(d->fds, d->nfds, timeout);
+    } else if (result > 0) {
+      d->spins++;
+    }
+  } else {
+    result = poll(d->fds, d->nfds, timeout);
+  }
   if (result == -1)
     pn_i_error_from_errno(d->error, "poll");
   return result;
@@ -694,11 +813,13 @@ int pn_driver_wait_3(pn_driver_t *d)
 
   pn_listener_t *l = d->listener_head;
   while (l) {
-    l->pending = (l->idx && d->fds[l->idx].revents & POLLIN);
+    l->pending = l->ahead != PN_INVALID_SOCKET ||
+      (l->idx && d->fds[l->idx].revents & POLLIN);
+    l->accepted = 0;
     l = l->listener_next;
   }
 
-  pn_timestamp_t now = pn_i_now();
+  pn_timestamp_t now = pn_i_monotonic_ms();
   pn_connector_t *c = d->connector_head;
   while (c) {
     if (c->closed) {
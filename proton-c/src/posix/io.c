@@ -19,6 +19,10 @@
  *
  */
 
+#ifdef USE_ACCEPT4
+#define _GNU_SOURCE
+#endif
+
 #include <proton/io.h>
 #include <proton/object.h>
 #include <proton/selector.h>
@@ -28,11 +32,15 @@
 #include <stdio.h>
 #include <sys/types.h>
 #include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
 #include <netinet/in.h>
 #include <netinet/tcp.h>
 #include <netdb.h>
 #include <unistd.h>
 #include <fcntl.h>
+#include <stddef.h>
+#include <string.h>
 #include <assert.h>
 
 #include "platform.h"
@@ -94,22 +102,18 @@ int pn_pipe(pn_io_t *io, pn_socket_t *dest)
   return n;
 }
 
-static void pn_configure_sock(pn_io_t *io, pn_socket_t sock) {
-  // this would be nice, but doesn't appear to exist on linux
-  /*
-  int set = 1;
-  if (!setsockopt(sock, SOL_SOCKET, SO_NOSIGPIPE, (void *)&set, sizeof(int))) {
-    pn_i_error_from_errno(io->error, "setsockopt");
-  };
-  */
-
+static void pn_set_nonblocking(pn_io_t *io, pn_socket_t sock)
+{
   int flags = fcntl(sock, F_GETFL);
   flags |= O_NONBLOCK;
 
   if (fcntl(sock, F_SETFL, flags) < 0) {
     pn_i_error_from_errno(io->error, "fcntl");
   }
+}
 
+static void pn_set_nodelay(pn_io_t *io, pn_socket_t sock)
+{
   //
   // Disable the Nagle algorithm on TCP connections.
   //
@@ -122,10 +126,130 @@ static void pn_configure_sock(pn_io_t *io, pn_socket_t sock) {
   }
 }
 
+static void pn_configure_sock(pn_io_t *io, pn_socket_t sock, bool tcp) {
+  // this would be nice, but doesn't appear to exist on linux
+  /*
+  int set = 1;
+  if (!setsockopt(sock, SOL_SOCKET, SO_NOSIGPIPE, (void *)&set, sizeof(int))) {
+    pn_i_error_from_errno(io->error, "setsockopt");
+  };
+  */
+
+  pn_set_nonblocking(io, sock);
+  if (tcp) pn_set_nodelay(io, sock);
+}
+
 static inline int pn_create_socket(int af);
 
+//
+// Hosts beginning with '/' name a filesystem AF_UNIX socket, hosts
+// beginning with '@' name a socket in the Linux abstract namespace;
+// the port is ignored for both.
+//
+static bool pni_is_unix_host(const char *host)
+{
+  return host && (host[0] == '/' || host[0] == '@');
+}
+
+static int pni_unix_addr(pn_io_t *io, const char *host, struct sockaddr_un *addr, socklen_t *len)
+{
+  size_t n = strlen(host);
+  if (n >= sizeof(addr->sun_path)) {
+    return pn_error_format(io->error, PN_ARG_ERR, "unix socket path too long: %s", host);
+  }
+  memset(addr, 0, sizeof(*addr));
+  addr->sun_family = AF_UNIX;
+  memcpy(addr->sun_path, host, n);
+  if (host[0] == '@') {
+    addr->sun_path[0] = '\0';
+  }
+  *len = offsetof(struct sockaddr_un, sun_path) + n;
+  return 0;
+}
+
+// a socket file is stale when nothing accepts connections on it
+static bool pni_unix_stale(struct sockaddr_un *addr, socklen_t len)
+{
+  pn_socket_t probe = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (probe == PN_INVALID_SOCKET) return false;
+  bool stale = connect(probe, (struct sockaddr *) addr, len) == -1 && errno == ECONNREFUSED;
+  close(probe);
+  return stale;
+}
+
+static pn_socket_t pni_listen_unix(pn_io_t *io, const char *host)
+{
+  struct sockaddr_un addr;
+  socklen_t len = sizeof(addr);
+  if (pni_unix_addr(io, host, &addr, &len)) return PN_INVALID_SOCKET;
+
+  pn_socket_t sock = pn_create_socket(AF_UNIX);
+  if (sock == PN_INVALID_SOCKET) {
+    pn_i_error_from_errno(io->error, "pn_create_socket");
+    return PN_INVALID_SOCKET;
+  }
+
+  // remove a stale socket left behind by a previous listener, but
+  // never one that a live listener still answers on
+  struct stat st;
+  if (host[0] == '/' && stat(host, &st) == 0 && S_ISSOCK(st.st_mode)) {
+    if (!pni_unix_stale(&addr, len)) {
+      pn_error_format(io->error, PN_ERR, "bind: address in use: %s", host);
+      close(sock);
+      return PN_INVALID_SOCKET;
+    }
+    unlink(host);
+  }
+
+  if (bind(sock, (struct sockaddr *) &addr, len) == -1) {
+    pn_i_error_from_errno(io->error, "bind");
+    close(sock);
+    return PN_INVALID_SOCKET;
+  }
+
+  if (listen(sock, 50) == -1) {
+    pn_i_error_from_errno(io->error, "listen");
+    close(sock);
+    return PN_INVALID_SOCKET;
+  }
+
+  // listeners are non-blocking so that callers may accept in a loop
+  // until pn_wouldblock()
+  pn_set_nonblocking(io, sock);
+  return sock;
+}
+
+static pn_socket_t pni_connect_unix(pn_io_t *io, const char *host)
+{
+  struct sockaddr_un addr;
+  socklen_t len = sizeof(addr);
+  if (pni_unix_addr(io, host, &addr, &len)) return PN_INVALID_SOCKET;
+
+  pn_socket_t sock = pn_create_socket(AF_UNIX);
+  if (sock == PN_INVALID_SOCKET) {
+    pn_i_error_from_errno(io->error, "pn_create_socket");
+    return PN_INVALID_SOCKET;
+  }
+
+  pn_configure_sock(io, sock, false);
+
+  if (connect(sock, (struct sockaddr *) &addr, len) == -1) {
+    // EAGAIN here means the listener's backlog is full, not that the
+    // connection is in progress
+    if (errno != EINPROGRESS) {
+      pn_i_error_from_errno(io->error, "connect");
+      close(sock);
+      return PN_INVALID_SOCKET;
+    }
+  }
+
+  return sock;
+}
+
 pn_socket_t pn_listen(pn_io_t *io, const char *host, const char *port)
 {
+  if (pni_is_unix_host(host)) return pni_listen_unix(io, host);
+
   struct addrinfo *addr;
   int code = getaddrinfo(host, port, NULL, &addr);
   if (code) {
@@ -161,11 +285,16 @@ pn_socket_t pn_listen(pn_io_t *io, const char *host, const char *port)
     return PN_INVALID_SOCKET;
   }
 
+  // listeners are non-blocking so that callers may accept in a loop
+  // until pn_wouldblock()
+  pn_set_nonblocking(io, sock);
   return sock;
 }
 
 pn_socket_t pn_connect(pn_io_t *io, const char *host, const char *port)
 {
+  if (pni_is_unix_host(host)) return pni_connect_unix(io, host);
+
   struct addrinfo *addr;
   int code = getaddrinfo(host, port, NULL, &addr);
   if (code) {
@@ -179,7 +308,7 @@ pn_socket_t pn_connect(pn_io_t *io, const char *host, const char *port)
     return PN_INVALID_SOCKET;
   }
 
-  pn_configure_sock(io, sock);
+  pn_configure_sock(io, sock, true);
 
   if (connect(sock, addr->ai_addr, addr->ai_addrlen) == -1) {
     if (errno != EINPROGRESS) {
@@ -197,12 +326,27 @@ pn_socket_t pn_connect(pn_io_t *io, const char *host, const char *port)
 
 pn_socket_t pn_accept(pn_io_t *io, pn_socket_t socket, char *name, size_t size)
 {
-  struct sockaddr_in addr = {0};
-  addr.sin_family = AF_UNSPEC;
+  struct sockaddr_storage addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.ss_family = AF_UNSPEC;
   socklen_t addrlen = sizeof(addr);
+#ifdef USE_ACCEPT4
+  pn_socket_t sock = accept4(socket, (struct sockaddr *) &addr, &addrlen, SOCK_NONBLOCK | SOCK_CLOEXEC);
+#else
   pn_socket_t sock = accept(socket, (struct sockaddr *) &addr, &addrlen);
+#endif
+  io->wouldblock = sock == PN_INVALID_SOCKET && (errno == EAGAIN || errno == EWOULDBLOCK);
   if (sock == PN_INVALID_SOCKET) {
-    pn_i_error_from_errno(io->error, "accept");
+    if (!io->wouldblock) {
+      pn_i_error_from_errno(io->error, "accept");
+    }
+    return sock;
+  } else if (addr.ss_family == AF_UNIX) {
+    // unix peers are normally unbound, so there is no name to report
+#ifndef USE_ACCEPT4
+    pn_set_nonblocking(io, sock);
+#endif
+    snprintf(name, size, "unix:%d", sock);
     return sock;
   } else {
     int code;
@@ -212,7 +356,10 @@ pn_socket_t pn_accept(pn_io_t *io, pn_socket_t socket, char *name, size_t size)
         pn_i_error_from_errno(io->error, "close");
       return PN_INVALID_SOCKET;
     } else {
-      pn_configure_sock(io, sock);
+#ifndef USE_ACCEPT4
+      pn_set_nonblocking(io, sock);
+#endif
+      pn_set_nodelay(io, sock);
       snprintf(name, size, "%s:%s", io->host, io->serv);
       return sock;
     }
@@ -228,6 +375,9 @@ ssize_t pn_send(pn_io_t *io, pn_socket_t socket, const void *buf, size_t len) {
 }
 
 static inline int pn_create_socket(int af) {
+  if (af == AF_UNIX) {
+    return socket(af, SOCK_STREAM, 0);
+  }
   struct protoent * pe_tcp = getprotobyname("tcp");
   if (pe_tcp == NULL) {
     return -1;
@@ -244,11 +394,15 @@ ssize_t pn_send(pn_io_t *io, pn_socket_t socket, const void *buf, size_t size) {
 static inline int pn_create_socket(int af) {
   struct protoent * pe_tcp;
   int sock;
-  pe_tcp = getprotobyname("tcp");
-  if (pe_tcp == NULL) {
-    return -1;
+  if (af == AF_UNIX) {
+    sock = socket(af, SOCK_STREAM, 0);
+  } else {
+    pe_tcp = getprotobyname("tcp");
+    if (pe_tcp == NULL) {
+      return -1;
+    }
+    sock = socket(af, SOCK_STREAM, pe_tcp->p_proto);
   }
-  sock = socket(af, SOCK_STREAM, pe_tcp->p_proto);
   if (sock == -1) return sock;
 
   int optval = 1;
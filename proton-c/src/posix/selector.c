@@ -22,14 +22,56 @@
 #include <proton/selector.h>
 #include <proton/error.h>
 #include <poll.h>
+#include <sys/socket.h>
 #include <stdlib.h>
+#include <string.h>
+#include <errno.h>
 #include <assert.h>
+#ifdef USE_EPOLL
+#include <sys/epoll.h>
+#include <unistd.h>
+#endif
 #include "platform.h"
 #include "selectable.h"
 #include "util.h"
 
+/*
+ * The selector keeps one pollfd per registered selectable. In poll
+ * mode the array is handed to poll() directly. In epoll mode it acts
+ * as a cache of the interest registered with the kernel, so that
+ * pn_selector_update only issues an epoll_ctl when the fd or the
+ * interest set actually changes, and epoll_wait results are written
+ * back into the revents fields for pn_selector_next to consume.
+ * Alongside it each slot records whether its fd is in the kernel's
+ * interest list and which of the selectable's fds it was: a closed fd
+ * drops out of the list, and its number may come back for a new
+ * socket that has to be added afresh.
+ *
+ * The backend is chosen when the selector is created: epoll is used
+ * where available unless the PN_SELECTOR environment variable is set
+ * to "poll".
+ *
+ * With a spin period set, pn_selector_select first polls without
+ * blocking for up to that many microseconds before falling back to a
+ * blocking wait for whatever remains of the timeout. This trades a
+ * busy core for not paying the scheduler wakeup latency on traffic
+ * that arrives shortly after the selector goes idle.
+ */
+
+#ifdef USE_EPOLL
+typedef struct {
+  unsigned int generation;  // of the selectable's fd when it was set
+  bool registered;          // the fd is in the epoll interest list
+} pni_epoll_slot_t;
+#endif
+
 struct pn_selector_t {
   struct pollfd *fds;
+#ifdef USE_EPOLL
+  struct epoll_event *events;
+  pni_epoll_slot_t *slots;
+  int epfd;
+#endif
   pn_timestamp_t *deadlines;
   size_t capacity;
   pn_list_t *selectables;
@@ -37,6 +79,10 @@ struct pn_selector_t {
   size_t current;
   pn_timestamp_t awoken;
   pn_error_t *error;
+  uint64_t spins;
+  uint64_t blocks;
+  int spin;
+  int busy_poll;
 };
 
 void pn_selector_initialize(void *obj)
@@ -50,6 +96,19 @@ void pn_selector_initialize(void *obj)
   selector->current = 0;
   selector->awoken = 0;
   selector->error = pn_error();
+  selector->spins = 0;
+  selector->blocks = 0;
+  selector->spin = 0;
+  selector->busy_poll = 0;
+#ifdef USE_EPOLL
+  selector->events = NULL;
+  selector->slots = NULL;
+  selector->epfd = -1;
+  const char *impl = getenv("PN_SELECTOR");
+  if (!impl || strcmp(impl, "poll")) {
+    selector->epfd = epoll_create1(EPOLL_CLOEXEC);
+  }
+#endif
 }
 
 void pn_selector_finalize(void *obj)
@@ -57,6 +116,11 @@ void pn_selector_finalize(void *obj)
   pn_selector_t *selector = (pn_selector_t *) obj;
   free(selector->fds);
   free(selector->deadlines);
+#ifdef USE_EPOLL
+  free(selector->events);
+  free(selector->slots);
+  if (selector->epfd >= 0) close(selector->epfd);
+#endif
   pn_free(selector->selectables);
   pn_error_free(selector->error);
 }
@@ -72,6 +136,17 @@ pn_selector_t *pni_selector(void)
   return selector;
 }
 
+static void pni_busy_poll(pn_socket_t fd, int usecs)
+{
+#ifdef SO_BUSY_POLL
+  // not every selectable is a socket and raising the value may need
+  // privileges, so failures here are ignored
+  if (fd != PN_INVALID_SOCKET) {
+    setsockopt(fd, SOL_SOCKET, SO_BUSY_POLL, &usecs, sizeof(usecs));
+  }
+#endif
+}
+
 void pn_selector_add(pn_selector_t *selector, pn_selectable_t *selectable)
 {
   assert(selector);
@@ -85,29 +160,99 @@ void pn_selector_add(pn_selector_t *selector, pn_selectable_t *selectable)
     if (selector->capacity < size) {
       selector->fds = (struct pollfd *) realloc(selector->fds, size*sizeof(struct pollfd));
       selector->deadlines = (pn_timestamp_t *) realloc(selector->deadlines, size*sizeof(pn_timestamp_t));
+#ifdef USE_EPOLL
+      selector->events = (struct epoll_event *) realloc(selector->events, size*sizeof(struct epoll_event));
+      selector->slots = (pni_epoll_slot_t *) realloc(selector->slots, size*sizeof(pni_epoll_slot_t));
+#endif
       selector->capacity = size;
     }
 
     pni_selectable_set_index(selectable, size - 1);
+    selector->fds[size - 1].fd = PN_INVALID_SOCKET;
+    selector->fds[size - 1].events = 0;
+#ifdef USE_EPOLL
+    selector->slots[size - 1].registered = false;
+#endif
   }
 
   pn_selector_update(selector, selectable);
 }
 
+#ifdef USE_EPOLL
+static void pni_epoll_del(pn_selector_t *selector, int idx)
+{
+  pni_epoll_slot_t *slot = &selector->slots[idx];
+  if (!slot->registered) return;
+  slot->registered = false;
+  // The descriptor may already have been closed, in which case the
+  // kernel has dropped it from the interest list already.
+  if (epoll_ctl(selector->epfd, EPOLL_CTL_DEL, selector->fds[idx].fd, NULL) == -1 &&
+      errno != ENOENT && errno != EBADF) {
+    pn_i_error_from_errno(selector->error, "epoll_ctl");
+  }
+}
+
+static void pni_epoll_ctl(pn_selector_t *selector, pn_selectable_t *selectable,
+                          int idx, pn_socket_t fd, short events)
+{
+  struct pollfd *pfd = &selector->fds[idx];
+  pni_epoll_slot_t *slot = &selector->slots[idx];
+  unsigned int generation = pni_selectable_get_generation(selectable);
+  bool same = slot->registered && pfd->fd == fd && slot->generation == generation;
+  if (same && pfd->events == events) return;
+
+  if (!same) pni_epoll_del(selector, idx);
+  pfd->fd = fd;
+  pfd->events = events;
+  slot->generation = generation;
+  if (fd == PN_INVALID_SOCKET) return;
+
+  struct epoll_event ev;
+  ev.events = ((events & POLLIN) ? EPOLLIN : 0) | ((events & POLLOUT) ? EPOLLOUT : 0);
+  ev.data.ptr = selectable;
+  // Our view of the interest list can still be wrong if an fd was
+  // closed and reopened behind the selectable's back, so fall back to
+  // the other operation rather than trust it.
+  int op = slot->registered ? EPOLL_CTL_MOD : EPOLL_CTL_ADD;
+  int err = epoll_ctl(selector->epfd, op, fd, &ev);
+  if (err == -1 && op == EPOLL_CTL_MOD && errno == ENOENT) {
+    err = epoll_ctl(selector->epfd, EPOLL_CTL_ADD, fd, &ev);
+  } else if (err == -1 && op == EPOLL_CTL_ADD && errno == EEXIST) {
+    err = epoll_ctl(selector->epfd, EPOLL_CTL_MOD, fd, &ev);
+  }
+  if (err == -1) {
+    pn_i_error_from_errno(selector->error, "epoll_ctl");
+  }
+  slot->registered = err != -1;
+}
+#endif
+
 void pn_selector_update(pn_selector_t *selector, pn_selectable_t *selectable)
 {
   int idx = pni_selectable_get_index(selectable);
   assert(idx >= 0);
-  selector->fds[idx].fd = pn_selectable_fd(selectable);
-  selector->fds[idx].events = 0;
-  selector->fds[idx].revents = 0;
+  pn_socket_t fd = pn_selectable_fd(selectable);
+  short events = 0;
   if (pn_selectable_capacity(selectable) > 0) {
-    selector->fds[idx].events |= POLLIN;
+    events |= POLLIN;
   }
   if (pn_selectable_pending(selectable) > 0) {
-    selector->fds[idx].events |= POLLOUT;
+    events |= POLLOUT;
   }
-  selector->deadlines[idx] = pn_selectable_deadline(selectable);
+  if (selector->busy_poll && selector->fds[idx].fd != fd) {
+    pni_busy_poll(fd, selector->busy_poll);
+  }
+#ifdef USE_EPOLL
+  if (selector->epfd >= 0) {
+    pni_epoll_ctl(selector, selectable, idx, fd, events);
+  } else
+#endif
+  {
+    selector->fds[idx].fd = fd;
+    selector->fds[idx].events = events;
+  }
+  selector->fds[idx].revents = 0;
+  selector->deadlines[idx] = pni_selectable_deadline(selectable);
 }
 
 void pn_selector_remove(pn_selector_t *selector, pn_selectable_t *selectable)
@@ -117,17 +262,61 @@ void pn_selector_remove(pn_selector_t *selector, pn_selectable_t *selectable)
 
   int idx = pni_selectable_get_index(selectable);
   assert(idx >= 0);
+#ifdef USE_EPOLL
+  if (selector->epfd >= 0) {
+    pni_epoll_del(selector, idx);
+  }
+#endif
   pn_list_del(selector->selectables, idx, 1);
   size_t size = pn_list_size(selector->selectables);
   for (size_t i = idx; i < size; i++) {
     pn_selectable_t *sel = (pn_selectable_t *) pn_list_get(selector->selectables, i);
     pni_selectable_set_index(sel, i);
     selector->fds[i] = selector->fds[i + 1];
+    selector->deadlines[i] = selector->deadlines[i + 1];
+#ifdef USE_EPOLL
+    selector->slots[i] = selector->slots[i + 1];
+#endif
   }
 
   pni_selectable_set_index(selectable, -1);
 }
 
+static int pni_selector_wait(pn_selector_t *selector, size_t size, int timeout)
+{
+#ifdef USE_EPOLL
+  if (selector->epfd >= 0) {
+    for (size_t i = 0; i < size; i++) {
+      selector->fds[i].revents = 0;
+    }
+    int result = size ? epoll_wait(selector->epfd, selector->events, size, timeout) : 0;
+    if (result == -1) {
+      pn_i_error_from_errno(selector->error, "epoll_wait");
+      return result;
+    }
+    if (!size && timeout) {
+      // nothing registered, but honour the timeout like poll() does
+      poll(NULL, 0, timeout);
+    }
+    for (int i = 0; i < result; i++) {
+      pn_selectable_t *sel = (pn_selectable_t *) selector->events[i].data.ptr;
+      int idx = pni_selectable_get_index(sel);
+      if (idx < 0) continue;
+      uint32_t ev = selector->events[i].events;
+      selector->fds[idx].revents = ((ev & EPOLLIN) ? POLLIN : 0) | ((ev & EPOLLOUT) ? POLLOUT : 0) |
+        ((ev & EPOLLERR) ? POLLERR : 0) | ((ev & EPOLLHUP) ? POLLHUP : 0);
+    }
+    return result;
+  }
+#endif
+
+  int result = poll(selector->fds, size, timeout);
+  if (result == -1) {
+    pn_i_error_from_errno(selector->error, "poll");
+  }
+  return result;
+}
+
 int pn_selector_select(pn_selector_t *selector, int timeout)
 {
   assert(selector);
@@ -143,25 +332,46 @@ int pn_selector_select(pn_selector_t *selector, int timeout)
     }
 
     if (deadline) {
-      pn_timestamp_t now = pn_i_now();
-      int delta = selector->deadline - now;
+      pn_timestamp_t now = pn_i_monotonic_ms();
+      int delta = deadline - now;
       if (delta < 0) {
         timeout = 0;
-      } else if (delta < timeout) {
+      } else if (timeout < 0 || delta < timeout) {
         timeout = delta;
       }
     }
   }
 
-  int result = poll(selector->fds, size, timeout);
-  if (result == -1) {
-    pn_i_error_from_errno(selector->error, "poll");
+  int result;
+  if (selector->spin && timeout) {
+    pn_timestamp_t start = pn_i_monotonic_us();
+    pn_timestamp_t elapsed = 0;
+    while (!(result = pni_selector_wait(selector, size, 0)) && elapsed < selector->spin &&
+           (timeout < 0 || elapsed < (pn_timestamp_t) timeout*1000)) {
+      elapsed = pn_i_monotonic_us() - start;
+    }
+    if (!result) {
+      if (timeout > 0) {
+        timeout = elapsed/1000 < timeout ? timeout - elapsed/1000 : 0;
+      }
+      selector->blocks++;
+      result = pni_selector_wait(selector, size, timeout);
+    } else if (result > 0) {
+      selector->spins++;
+    }
   } else {
+    result = pni_selector_wait(selector, size, timeout);
+  }
+
+  if (result >= 0) {
     selector->current = 0;
-    selector->awoken = pn_i_now();
+    selector->awoken = pn_i_monotonic_ms();
   }
 
-  return pn_error_code(selector->error);
+  // report each failure once, including any from pn_selector_update
+  int err = pn_error_code(selector->error);
+  pn_error_clear(selector->error);
+  return err;
 }
 
 pn_selectable_t *pn_selector_next(pn_selector_t *selector, int *events)
@@ -191,6 +401,40 @@ pn_selectable_t *pn_selector_next(pn_selector_t *selector, int *events)
   return NULL;
 }
 
+void pn_selector_set_spin(pn_selector_t *selector, int usecs)
+{
+  assert(selector);
+  selector->spin = usecs > 0 ? usecs : 0;
+}
+
+int pn_selector_get_spin(pn_selector_t *selector)
+{
+  assert(selector);
+  return selector->spin;
+}
+
+void pn_selector_set_busy_poll(pn_selector_t *selector, int usecs)
+{
+  assert(selector);
+  selector->busy_poll = usecs > 0 ? usecs : 0;
+  size_t size = pn_list_size(selector->selectables);
+  for (size_t i = 0; i < size; i++) {
+    pni_busy_poll(selector->fds[i].fd, selector->busy_poll);
+  }
+}
+
+uint64_t pn_selector_spins(pn_selector_t *selector)
+{
+  assert(selector);
+  return selector->spins;
+}
+
+uint64_t pn_selector_blocks(pn_selector_t *selector)
+{
+  assert(selector);
+  return selector->blocks;
+}
+
 void pn_selector_free(pn_selector_t *selector)
 {
   assert(selector);
@@ -0,0 +1,377 @@
+/*
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ *
+ */
+
+#define _GNU_SOURCE
+
+#include <proton/shm.h>
+#include <proton/object.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <assert.h>
+
+#include "platform.h"
+#include "util.h"
+
+#define PNI_SHM_MAGIC (0x414d5150)
+#define PNI_SHM_MIN_CAPACITY (4096)
+
+//
+// Each ring is a classic single-producer/single-consumer buffer.
+// head and tail are free running byte counters; the producer only
+// ever writes head and the consumer only ever writes tail, so the
+// only synchronization needed is acquire/release ordering on the two
+// counters. They live on separate cache lines to avoid false sharing
+// between the two processes.
+//
+typedef struct {
+  uint64_t head;
+  char pad0[56];
+  uint64_t tail;
+  char pad1[56];
+  uint32_t closed;
+  char pad2[60];
+} pni_ring_t;
+
+typedef struct {
+  uint32_t magic;
+  uint32_t pad;
+  uint64_t capacity;
+  char pad0[48];
+  pni_ring_t rings[2];
+} pni_shm_header_t;
+
+struct pn_shm_t {
+  pn_error_t *error;
+  pn_transport_t *transport;
+  pni_shm_header_t *header;
+  char *data;
+  size_t size;
+  uint64_t capacity;
+  int side;
+  int memfd;
+  int bells[2];
+  bool tail_closed;
+  bool head_closed;
+};
+
+static void pn_shm_initialize(void *object)
+{
+  pn_shm_t *shm = (pn_shm_t *) object;
+  shm->error = pn_error();
+  shm->transport = NULL;
+  shm->header = NULL;
+  shm->data = NULL;
+  shm->size = 0;
+  shm->capacity = 0;
+  shm->side = 0;
+  shm->memfd = -1;
+  shm->bells[0] = -1;
+  shm->bells[1] = -1;
+  shm->tail_closed = false;
+  shm->head_closed = false;
+}
+
+static pni_ring_t *pni_shm_inbound(pn_shm_t *shm)
+{
+  return &shm->header->rings[1 - shm->side];
+}
+
+static pni_ring_t *pni_shm_outbound(pn_shm_t *shm)
+{
+  return &shm->header->rings[shm->side];
+}
+
+static char *pni_shm_ring_data(pn_shm_t *shm, int ring)
+{
+  return shm->data + ring*shm->capacity;
+}
+
+static void pni_shm_ring_bell(pn_shm_t *shm)
+{
+  uint64_t one = 1;
+  ssize_t n = write(shm->bells[1 - shm->side], &one, sizeof(one));
+  (void) n;  // EAGAIN means the counter is saturated, the peer will wake
+}
+
+static void pn_shm_finalize(void *object)
+{
+  pn_shm_t *shm = (pn_shm_t *) object;
+  if (shm->header) {
+    __atomic_store_n(&pni_shm_outbound(shm)->closed, 1, __ATOMIC_RELEASE);
+    pni_shm_ring_bell(shm);
+    munmap(shm->header, shm->size);
+  }
+  if (shm->memfd >= 0) close(shm->memfd);
+  if (shm->bells[0] >= 0) close(shm->bells[0]);
+  if (shm->bells[1] >= 0) close(shm->bells[1]);
+  pn_decref(shm->transport);
+  pn_error_free(shm->error);
+}
+
+#define pn_shm_hashcode NULL
+#define pn_shm_compare NULL
+#define pn_shm_inspect NULL
+
+static pn_shm_t *pni_shm(void)
+{
+  static const pn_class_t clazz = PN_CLASS(pn_shm);
+  return (pn_shm_t *) pn_class_new(&clazz, sizeof(pn_shm_t));
+}
+
+static int pni_shm_map(pn_shm_t *shm)
+{
+  void *addr = mmap(NULL, shm->size, PROT_READ | PROT_WRITE, MAP_SHARED, shm->memfd, 0);
+  if (addr == MAP_FAILED) {
+    return pn_i_error_from_errno(shm->error, "mmap");
+  }
+  shm->header = (pni_shm_header_t *) addr;
+  shm->data = (char *) addr + sizeof(pni_shm_header_t);
+  return 0;
+}
+
+pn_shm_t *pn_shm(size_t capacity)
+{
+  uint64_t cap = PNI_SHM_MIN_CAPACITY;
+  while (cap < capacity) cap *= 2;
+
+  pn_shm_t *shm = pni_shm();
+  shm->side = 0;
+  shm->capacity = cap;
+  shm->size = sizeof(pni_shm_header_t) + 2*cap;
+  shm->memfd = memfd_create("proton-shm", MFD_CLOEXEC);
+  shm->bells[0] = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  shm->bells[1] = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (shm->memfd < 0 || shm->bells[0] < 0 || shm->bells[1] < 0 ||
+      ftruncate(shm->memfd, shm->size) || pni_shm_map(shm)) {
+    pn_free(shm);
+    return NULL;
+  }
+
+  memset(shm->header, 0, sizeof(pni_shm_header_t));
+  shm->header->capacity = cap;
+  __atomic_store_n(&shm->header->magic, PNI_SHM_MAGIC, __ATOMIC_RELEASE);
+  return shm;
+}
+
+pn_shm_t *pn_shm_attach(const int fds[3])
+{
+  pn_shm_t *shm = pni_shm();
+  shm->side = 1;
+  shm->memfd = fcntl(fds[0], F_DUPFD_CLOEXEC, 0);
+  shm->bells[0] = fcntl(fds[1], F_DUPFD_CLOEXEC, 0);
+  shm->bells[1] = fcntl(fds[2], F_DUPFD_CLOEXEC, 0);
+
+  struct stat st;
+  if (shm->memfd < 0 || shm->bells[0] < 0 || shm->bells[1] < 0 ||
+      fstat(shm->memfd, &st) || st.st_size < (off_t) sizeof(pni_shm_header_t)) {
+    pn_free(shm);
+    return NULL;
+  }
+
+  shm->size = st.st_size;
+  if (pni_shm_map(shm) ||
+      __atomic_load_n(&shm->header->magic, __ATOMIC_ACQUIRE) != PNI_SHM_MAGIC) {
+    pn_free(shm);
+    return NULL;
+  }
+
+  // the rings are indexed by masking, so their capacity has to be a
+  // power of two, and both have to fit the segment exactly
+  uint64_t capacity = shm->header->capacity;
+  if (!capacity || (capacity & (capacity - 1)) ||
+      capacity != (shm->size - sizeof(pni_shm_header_t))/2 ||
+      sizeof(pni_shm_header_t) + 2*capacity != shm->size) {
+    pn_free(shm);
+    return NULL;
+  }
+
+  shm->capacity = capacity;
+  return shm;
+}
+
+void pn_shm_fds(pn_shm_t *shm, int fds[3])
+{
+  assert(shm);
+  fds[0] = shm->memfd;
+  fds[1] = shm->bells[0];
+  fds[2] = shm->bells[1];
+}
+
+void pn_shm_free(pn_shm_t *shm)
+{
+  pn_free(shm);
+}
+
+pn_error_t *pn_shm_error(pn_shm_t *shm)
+{
+  assert(shm);
+  return shm->error;
+}
+
+int pn_shm_bind(pn_shm_t *shm, pn_transport_t *transport)
+{
+  assert(shm);
+  if (shm->transport) {
+    return pn_error_format(shm->error, PN_STATE_ERR, "already bound");
+  }
+  shm->transport = transport;
+  pn_incref(transport);
+  return 0;
+}
+
+pn_socket_t pn_shm_fd(pn_shm_t *shm)
+{
+  assert(shm);
+  return shm->bells[shm->side];
+}
+
+// the counters are written by both processes, so a broken peer can
+// leave them further apart than a ring holds
+static ssize_t pni_shm_corrupt(pn_shm_t *shm, uint64_t head, uint64_t tail)
+{
+  return pn_error_format(shm->error, PN_STATE_ERR,
+                         "ring corrupt: head %" PRIu64 ", tail %" PRIu64 ", capacity %" PRIu64,
+                         head, tail, shm->capacity);
+}
+
+static ssize_t pni_shm_read(pn_shm_t *shm)
+{
+  pni_ring_t *ring = pni_shm_inbound(shm);
+  char *data = pni_shm_ring_data(shm, 1 - shm->side);
+  uint64_t mask = shm->capacity - 1;
+  size_t moved = 0;
+
+  while (!shm->tail_closed) {
+    ssize_t capacity = pn_transport_capacity(shm->transport);
+    if (capacity < 0) {
+      shm->tail_closed = true;
+      break;
+    }
+
+    // closed must be observed before head so that a closed ring is
+    // known to be fully drained once tail catches up
+    uint32_t closed = __atomic_load_n(&ring->closed, __ATOMIC_ACQUIRE);
+    uint64_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+    uint64_t tail = ring->tail;
+    if (head - tail > shm->capacity) return pni_shm_corrupt(shm, head, tail);
+    size_t available = head - tail;
+
+    if (!available) {
+      if (closed) {
+        pn_transport_close_tail(shm->transport);
+        shm->tail_closed = true;
+      }
+      break;
+    }
+    if (!capacity) break;
+
+    size_t n = pn_min((size_t) capacity, available);
+    size_t offset = tail & mask;
+    size_t first = pn_min(n, shm->capacity - offset);
+    char *dst = pn_transport_tail(shm->transport);
+    memcpy(dst, data + offset, first);
+    memcpy(dst + first, data, n - first);
+    __atomic_store_n(&ring->tail, tail + n, __ATOMIC_RELEASE);
+    moved += n;
+
+    if (pn_transport_process(shm->transport, n) < 0) {
+      shm->tail_closed = true;
+    }
+  }
+
+  return moved;
+}
+
+static ssize_t pni_shm_write(pn_shm_t *shm)
+{
+  pni_ring_t *ring = pni_shm_outbound(shm);
+  char *data = pni_shm_ring_data(shm, shm->side);
+  uint64_t mask = shm->capacity - 1;
+  size_t moved = 0;
+
+  while (!shm->head_closed) {
+    ssize_t pending = pn_transport_pending(shm->transport);
+    if (pending < 0) {
+      __atomic_store_n(&ring->closed, 1, __ATOMIC_RELEASE);
+      shm->head_closed = true;
+      break;
+    }
+    if (!pending) break;
+
+    uint64_t head = ring->head;
+    uint64_t tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+    if (head - tail > shm->capacity) return pni_shm_corrupt(shm, head, tail);
+    size_t space = shm->capacity - (head - tail);
+    if (!space) break;
+
+    size_t n = pn_min((size_t) pending, space);
+    size_t offset = head & mask;
+    size_t first = pn_min(n, shm->capacity - offset);
+    const char *src = pn_transport_head(shm->transport);
+    memcpy(data + offset, src, first);
+    memcpy(data, src + first, n - first);
+    __atomic_store_n(&ring->head, head + n, __ATOMIC_RELEASE);
+    pn_transport_pop(shm->transport, n);
+    moved += n;
+  }
+
+  return moved;
+}
+
+ssize_t pn_shm_pump(pn_shm_t *shm)
+{
+  assert(shm);
+  if (!shm->transport) {
+    return pn_error_format(shm->error, PN_STATE_ERR, "no transport bound");
+  }
+
+  uint64_t count;
+  ssize_t n = read(shm->bells[shm->side], &count, sizeof(count));
+  if (n < 0 && errno != EAGAIN) {
+    return pn_i_error_from_errno(shm->error, "read");
+  }
+
+  bool was_closed = shm->head_closed;
+  ssize_t in = pni_shm_read(shm);
+  if (in < 0) return in;
+  ssize_t out = pni_shm_write(shm);
+  if (out < 0) return out;
+  size_t moved = in + out;
+
+  // consuming input frees space the peer may be blocked on, so the
+  // bell is rung for traffic in either direction
+  if (moved || shm->head_closed != was_closed) {
+    pni_shm_ring_bell(shm);
+  }
+
+  if (!moved && shm->tail_closed && shm->head_closed) {
+    return PN_EOS;
+  }
+  return moved;
+}
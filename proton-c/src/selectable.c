@@ -22,6 +22,7 @@
 #include <proton/error.h>
 #include <proton/io.h>
 #include "selectable.h"
+#include "platform.h"
 #include <stdlib.h>
 #include <assert.h>
 
@@ -42,6 +43,7 @@ void pn_selectables_free(pn_selectables_t *selectables)
 
 struct pn_selectable_t {
   pn_socket_t fd;
+  unsigned int generation;  // bumped each time the fd is set
   int index;
   void *context;
   ssize_t (*capacity)(pn_selectable_t *);
@@ -59,6 +61,7 @@ void pn_selectable_initialize(void *obj)
 {
   pn_selectable_t *sel = (pn_selectable_t *) obj;
   sel->fd = PN_INVALID_SOCKET;
+  sel->generation = 0;
   sel->index = -1;
   sel->context = NULL;
   sel->capacity = NULL;
@@ -136,6 +139,13 @@ void pni_selectable_set_fd(pn_selectable_t *selectable, pn_socket_t fd)
 {
   assert(selectable);
   selectable->fd = fd;
+  selectable->generation++;
+}
+
+unsigned int pni_selectable_get_generation(pn_selectable_t *selectable)
+{
+  assert(selectable);
+  return selectable->generation;
 }
 
 ssize_t pn_selectable_capacity(pn_selectable_t *selectable)
@@ -151,6 +161,13 @@ ssize_t pn_selectable_pending(pn_selectable_t *selectable)
 }
 
 pn_timestamp_t pn_selectable_deadline(pn_selectable_t *selectable)
+{
+  assert(selectable);
+  pn_timestamp_t deadline = selectable->deadline(selectable);
+  return deadline ? deadline + pn_i_monotonic_epoch() : 0;
+}
+
+pn_timestamp_t pni_selectable_deadline(pn_selectable_t *selectable)
 {
   assert(selectable);
   return selectable->deadline(selectable);
@@ -38,8 +38,11 @@ pn_selectable_t *pni_selectable(ssize_t (*capacity)(pn_selectable_t *),
 void *pni_selectable_get_context(pn_selectable_t *selectable);
 void pni_selectable_set_context(pn_selectable_t *selectable, void *context);
 void pni_selectable_set_fd(pn_selectable_t *selectable, pn_socket_t fd);
+unsigned int pni_selectable_get_generation(pn_selectable_t *selectable);
 void pni_selectable_set_terminal(pn_selectable_t *selectable, bool terminal);
 int pni_selectable_get_index(pn_selectable_t *selectable);
+// the deadline on the monotonic clock, as selectors compare it
+pn_timestamp_t pni_selectable_deadline(pn_selectable_t *selectable);
 void pni_selectable_set_index(pn_selectable_t *selectable, int index);
 
 #endif /* selectable.h */
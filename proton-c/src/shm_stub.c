@@ -0,0 +1,67 @@
+/*
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ *
+ */
+
+#include <proton/shm.h>
+
+/** @file
+ * Shared memory transport binding.
+ *
+ * This file contains stub implementations of the shared memory API.  This
+ * implementation is used where memfd and eventfd are not available.
+ */
+
+pn_shm_t *pn_shm(size_t capacity)
+{
+  return NULL;
+}
+
+pn_shm_t *pn_shm_attach(const int fds[3])
+{
+  return NULL;
+}
+
+void pn_shm_fds(pn_shm_t *shm, int fds[3])
+{
+}
+
+void pn_shm_free(pn_shm_t *shm)
+{
+}
+
+pn_error_t *pn_shm_error(pn_shm_t *shm)
+{
+  return NULL;
+}
+
+int pn_shm_bind(pn_shm_t *shm, pn_transport_t *transport)
+{
+  return PN_ERR;
+}
+
+pn_socket_t pn_shm_fd(pn_shm_t *shm)
+{
+  return PN_INVALID_SOCKET;
+}
+
+ssize_t pn_shm_pump(pn_shm_t *shm)
+{
+  return PN_EOS;
+}
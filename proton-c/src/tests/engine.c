@@ -291,12 +291,422 @@ int test_free_link(int argc, char **argv)
     return 0;
 }
 
+// test that the message format of a delivery reaches the peer, and
+// that terminus capabilities can be queried
+int test_message_format(int argc, char **argv)
+{
+    fprintf(stdout, "test_message_format\n");
+    pn_connection_t *c1 = pn_connection();
+    pn_transport_t  *t1 = pn_transport();
+    pn_transport_bind(t1, c1);
+
+    pn_connection_t *c2 = pn_connection();
+    pn_transport_t  *t2 = pn_transport();
+    pn_transport_bind(t2, c2);
+
+    test_setup(c1, t1,
+               c2, t2);
+
+    pn_link_t *tx = pn_link_head(c1, (PN_LOCAL_ACTIVE | PN_REMOTE_ACTIVE));
+    assert(tx);
+    pn_link_t *rx = pn_link_head(c2, (PN_LOCAL_ACTIVE | PN_REMOTE_ACTIVE));
+    assert(rx);
+
+    // capabilities may be a lone symbol or an array of symbols
+    pn_terminus_t *target = pn_link_target(rx);
+    assert(!pn_terminus_has_capability(target, "x-opt-batch"));
+    pn_data_put_symbol(pn_terminus_capabilities(target), pn_bytes(11, "x-opt-batch"));
+    assert(pn_terminus_has_capability(target, "x-opt-batch"));
+    assert(!pn_terminus_has_capability(target, "x-opt"));
+    pn_data_t *caps = pn_terminus_capabilities(target);
+    pn_data_clear(caps);
+    pn_data_put_array(caps, false, PN_SYMBOL);
+    pn_data_enter(caps);
+    pn_data_put_symbol(caps, pn_bytes(5, "other"));
+    pn_data_put_symbol(caps, pn_bytes(11, "x-opt-batch"));
+    pn_data_exit(caps);
+    assert(pn_terminus_has_capability(target, "x-opt-batch"));
+    assert(!pn_terminus_has_capability(target, "x-opt-none"));
+
+    pn_link_flow(rx, 10);
+    pn_delivery_t *d1 = pn_delivery(tx, pn_dtag("tag-1", 6));
+    assert(pn_delivery_message_format(d1) == 0);
+    pn_delivery_set_message_format(d1, 0x12345678);
+    while (pump(t1, t2)) {
+        process_endpoints(c1);
+        process_endpoints(c2);
+    }
+    assert(pn_delivery_writable(d1));
+    pn_link_send(tx, "ABC", 4);
+    pn_link_advance(tx);
+
+    while (pump(t1, t2)) {
+        process_endpoints(c1);
+        process_endpoints(c2);
+    }
+
+    pn_delivery_t *d2 = pn_link_current(rx);
+    assert(d2);
+    assert(pn_delivery_message_format(d2) == 0x12345678);
+
+    pn_transport_unbind(t1);
+    pn_transport_free(t1);
+    pn_connection_free(c1);
+
+    pn_transport_unbind(t2);
+    pn_transport_free(t2);
+    pn_connection_free(c2);
+
+    return 0;
+}
+
+// test that a payload can be shared by several deliveries without
+// copying, and is released once written
+int test_shared_payload(int argc, char **argv)
+{
+    fprintf(stdout, "test_shared_payload\n");
+    pn_connection_t *c1 = pn_connection();
+    pn_transport_t  *t1 = pn_transport();
+    pn_transport_bind(t1, c1);
+
+    pn_connection_t *c2 = pn_connection();
+    pn_transport_t  *t2 = pn_transport();
+    pn_transport_bind(t2, c2);
+
+    test_setup(c1, t1,
+               c2, t2);
+
+    pn_link_t *tx = pn_link_head(c1, (PN_LOCAL_ACTIVE | PN_REMOTE_ACTIVE));
+    assert(tx);
+    pn_link_t *rx = pn_link_head(c2, (PN_LOCAL_ACTIVE | PN_REMOTE_ACTIVE));
+    assert(rx);
+
+    pn_payload_t *payload = pn_payload("ABCDEF", 6);
+    assert(pn_payload_size(payload) == 6);
+
+    pn_link_flow(rx, 10);
+    pn_delivery_t *d1 = pn_delivery(tx, pn_dtag("tag-1", 6));
+    assert(pn_link_send_payload(tx, payload) == 6);
+    assert(pn_delivery_pending(d1) == 6);
+    pn_link_advance(tx);
+    pn_delivery_t *d2 = pn_delivery(tx, pn_dtag("tag-2", 6));
+    assert(pn_link_send_payload(tx, payload) == 6);
+    // data sent after a payload follows it
+    assert(pn_link_send(tx, "GH", 2) == 2);
+    assert(pn_delivery_pending(d2) == 8);
+    pn_link_advance(tx);
+    assert(pn_refcount(payload) == 2);
+
+    while (pump(t1, t2)) {
+        process_endpoints(c1);
+        process_endpoints(c2);
+    }
+
+    // both deliveries are written, so only our reference remains
+    assert(pn_refcount(payload) == 1);
+    pn_payload_free(payload);
+
+    char buf[16];
+    assert(pn_link_recv(rx, buf, sizeof(buf)) == 6);
+    assert(!memcmp(buf, "ABCDEF", 6));
+    pn_link_advance(rx);
+    assert(pn_link_recv(rx, buf, sizeof(buf)) == 8);
+    assert(!memcmp(buf, "ABCDEFGH", 8));
+
+    pn_transport_unbind(t1);
+    pn_transport_free(t1);
+    pn_connection_free(c1);
+
+    pn_transport_unbind(t2);
+    pn_transport_free(t2);
+    pn_connection_free(c2);
+
+    return 0;
+}
+
+// test that a delivery waiting for credit can be withdrawn without
+// ever reaching the peer
+int test_abort_delivery(int argc, char **argv)
+{
+    fprintf(stdout, "test_abort_delivery\n");
+    pn_connection_t *c1 = pn_connection();
+    pn_transport_t  *t1 = pn_transport();
+    pn_transport_bind(t1, c1);
+
+    pn_connection_t *c2 = pn_connection();
+    pn_transport_t  *t2 = pn_transport();
+    pn_transport_bind(t2, c2);
+
+    test_setup(c1, t1,
+               c2, t2);
+
+    pn_link_t *tx = pn_link_head(c1, (PN_LOCAL_ACTIVE | PN_REMOTE_ACTIVE));
+    assert(tx);
+    pn_link_t *rx = pn_link_head(c2, (PN_LOCAL_ACTIVE | PN_REMOTE_ACTIVE));
+    assert(rx);
+
+    // no credit yet, so both deliveries stay buffered
+    pn_delivery_t *d1 = pn_delivery(tx, pn_dtag("tag-1", 6));
+    pn_link_send(tx, "ABC", 4);
+    pn_link_advance(tx);
+    pn_delivery_t *d2 = pn_delivery(tx, pn_dtag("tag-2", 6));
+    pn_link_send(tx, "DEF", 4);
+    pn_link_advance(tx);
+    assert(pn_link_queued(tx) == 2);
+
+    assert(pn_delivery_abort(d1) == 0);
+    assert(pn_link_queued(tx) == 1);
+    assert(pn_link_unsettled(tx) == 1);
+    assert(pn_delivery_abort(d1) == PN_STATE_ERR);
+
+    pn_link_flow(rx, 10);
+    while (pump(t1, t2)) {
+        process_endpoints(c1);
+        process_endpoints(c2);
+    }
+
+    // once written, a delivery can no longer be withdrawn
+    assert(pn_delivery_abort(d2) == PN_STATE_ERR);
+
+    char buf[16];
+    assert(pn_link_queued(rx) == 1);
+    assert(pn_link_recv(rx, buf, sizeof(buf)) == 4);
+    assert(!strcmp(buf, "DEF"));
+
+    pn_transport_unbind(t1);
+    pn_transport_free(t1);
+    pn_connection_free(c1);
+
+    pn_transport_unbind(t2);
+    pn_transport_free(t2);
+    pn_connection_free(c2);
+
+    return 0;
+}
+
+// test that a transport's input buffer grows for one large message and
+// shrinks back once traffic returns to small messages
+int test_buffer_shrink(int argc, char **argv)
+{
+    fprintf(stdout, "test_buffer_shrink\n");
+    pn_connection_t *c1 = pn_connection();
+    pn_transport_t  *t1 = pn_transport();
+    pn_transport_bind(t1, c1);
+
+    pn_connection_t *c2 = pn_connection();
+    pn_transport_t  *t2 = pn_transport();
+    pn_transport_bind(t2, c2);
+
+    test_setup(c1, t1,
+               c2, t2);
+
+    pn_link_t *tx = pn_link_head(c1, (PN_LOCAL_ACTIVE | PN_REMOTE_ACTIVE));
+    assert(tx);
+    pn_link_t *rx = pn_link_head(c2, (PN_LOCAL_ACTIVE | PN_REMOTE_ACTIVE));
+    assert(rx);
+
+    ssize_t initial = pn_transport_capacity(t2);
+    pn_link_flow(rx, 1000);
+
+    size_t size = 256*1024;
+    char *big = (char *) calloc(size, 1);
+    char *buf = (char *) malloc(size);
+    pn_delivery(tx, pn_dtag("big", 4));
+    pn_link_send(tx, big, size);
+    pn_link_advance(tx);
+    while (pump(t1, t2)) {
+        process_endpoints(c1);
+        process_endpoints(c2);
+    }
+    assert(pn_link_recv(rx, buf, size) == (ssize_t) size);
+    pn_link_advance(rx);
+    assert(pn_transport_capacity(t2) > initial);
+
+    for (int i = 0; i < 500; i++) {
+        pn_delivery(tx, pn_dtag((char *) &i, sizeof(i)));
+        pn_link_send(tx, "small", 5);
+        pn_link_advance(tx);
+        while (pump(t1, t2)) {
+            process_endpoints(c1);
+            process_endpoints(c2);
+        }
+        assert(pn_link_recv(rx, buf, size) == 5);
+        pn_link_advance(rx);
+    }
+    assert(pn_transport_capacity(t2) == initial);
+
+    free(big);
+    free(buf);
+
+    pn_transport_unbind(t1);
+    pn_transport_free(t1);
+    pn_connection_free(c1);
+
+    pn_transport_unbind(t2);
+    pn_transport_free(t2);
+    pn_connection_free(c2);
+
+    return 0;
+}
+
+// a connection that goes quiet after a burst gives back the space the
+// burst needed once it has been idle for a while
+int test_idle_shrink(int argc, char **argv)
+{
+    fprintf(stdout, "test_idle_shrink\n");
+    pn_connection_t *c1 = pn_connection();
+    pn_transport_t  *t1 = pn_transport();
+    pn_transport_bind(t1, c1);
+
+    pn_connection_t *c2 = pn_connection();
+    pn_transport_t  *t2 = pn_transport();
+    pn_transport_bind(t2, c2);
+
+    test_setup(c1, t1,
+               c2, t2);
+
+    pn_link_t *tx = pn_link_head(c1, (PN_LOCAL_ACTIVE | PN_REMOTE_ACTIVE));
+    assert(tx);
+    pn_link_t *rx = pn_link_head(c2, (PN_LOCAL_ACTIVE | PN_REMOTE_ACTIVE));
+    assert(rx);
+
+    ssize_t initial = pn_transport_capacity(t2);
+    assert(!pn_transport_tick(t2, 1000));
+    pn_link_flow(rx, 1);
+
+    size_t size = 256*1024;
+    char *big = (char *) calloc(size, 1);
+    char *buf = (char *) malloc(size);
+    pn_delivery(tx, pn_dtag("big", 4));
+    pn_link_send(tx, big, size);
+    pn_link_advance(tx);
+    while (pump(t1, t2)) {
+        process_endpoints(c1);
+        process_endpoints(c2);
+    }
+    assert(pn_link_recv(rx, buf, size) == (ssize_t) size);
+    pn_link_advance(rx);
+    assert(pn_transport_capacity(t2) > initial);
+
+    // the tick after the burst asks for another once the idle time is up
+    pn_timestamp_t deadline = pn_transport_tick(t2, 2000);
+    assert(deadline > 2000);
+    assert(pn_transport_tick(t2, deadline - 1) == deadline);
+    assert(pn_transport_capacity(t2) > initial);
+    assert(!pn_transport_tick(t2, deadline));
+    assert(pn_transport_capacity(t2) == initial);
+
+    free(big);
+    free(buf);
+
+    pn_transport_unbind(t1);
+    pn_transport_free(t1);
+    pn_connection_free(c1);
+
+    pn_transport_unbind(t2);
+    pn_transport_free(t2);
+    pn_connection_free(c2);
+
+    return 0;
+}
+
+// send one delivery on tx and transfer it across to rx
+static pn_delivery_t *send_one(pn_link_t *tx, const char *tag,
+                               pn_transport_t *t1, pn_transport_t *t2)
+{
+    pn_delivery_t *d = pn_delivery(tx, pn_dtag(tag, strlen(tag)));
+    pn_link_send(tx, tag, strlen(tag));
+    pn_link_advance(tx);
+    while (pump(t1, t2)) {
+        process_endpoints(pn_transport_connection(t1));
+        process_endpoints(pn_transport_connection(t2));
+    }
+    return d;
+}
+
+// test that a receiving link disposes of deliveries in each auto mode
+int test_rcv_auto_mode(int argc, char **argv)
+{
+    fprintf(stdout, "test_rcv_auto_mode\n");
+    pn_connection_t *c1 = pn_connection();
+    pn_transport_t  *t1 = pn_transport();
+    pn_transport_bind(t1, c1);
+
+    pn_connection_t *c2 = pn_connection();
+    pn_transport_t  *t2 = pn_transport();
+    pn_transport_bind(t2, c2);
+
+    test_setup(c1, t1,
+               c2, t2);
+
+    pn_link_t *tx = pn_link_head(c1, (PN_LOCAL_ACTIVE | PN_REMOTE_ACTIVE));
+    assert(tx);
+    pn_link_t *rx = pn_link_head(c2, (PN_LOCAL_ACTIVE | PN_REMOTE_ACTIVE));
+    assert(rx);
+    assert(pn_link_rcv_auto_mode(rx) == PN_RCV_AUTO_NONE);
+    pn_link_flow(rx, 10);
+    char buf[16];
+
+    // accepted on arrival, but left for the application to settle
+    pn_link_set_rcv_auto_mode(rx, PN_RCV_AUTO_ACCEPT);
+    pn_delivery_t *d1 = send_one(tx, "one", t1, t2);
+    assert(pn_delivery_remote_state(d1) == PN_ACCEPTED);
+    assert(!pn_delivery_settled(d1));
+    assert(pn_link_recv(rx, buf, sizeof(buf)) == 3);
+    pn_delivery_t *r1 = pn_link_current(rx);
+    pn_link_advance(rx);
+    assert(pn_link_unsettled(rx) == 1);
+    pn_delivery_settle(r1);
+    pn_delivery_settle(d1);
+
+    // settled on arrival, recycled once read
+    pn_link_set_rcv_auto_mode(rx, PN_RCV_AUTO_SETTLE);
+    pn_delivery_t *d2 = send_one(tx, "two", t1, t2);
+    assert(pn_delivery_settled(d2));
+    assert(pn_link_unsettled(rx) == 0);
+    assert(pn_link_recv(rx, buf, sizeof(buf)) == 3);
+    assert(!memcmp(buf, "two", 3));
+    pn_link_advance(rx);
+    pn_delivery_settle(d2);
+
+    // accepted and settled only once the application moves past it
+    pn_link_set_rcv_auto_mode(rx, PN_RCV_AUTO_ACCEPT_ON_ADVANCE);
+    pn_delivery_t *d3 = send_one(tx, "three", t1, t2);
+    assert(!pn_delivery_remote_state(d3));
+    assert(pn_link_recv(rx, buf, sizeof(buf)) == 5);
+    pn_link_advance(rx);
+    assert(pn_link_unsettled(rx) == 0);
+    while (pump(t1, t2)) {
+        process_endpoints(c1);
+        process_endpoints(c2);
+    }
+    assert(pn_delivery_remote_state(d3) == PN_ACCEPTED);
+    assert(pn_delivery_settled(d3));
+    pn_delivery_settle(d3);
+
+    pn_transport_unbind(t1);
+    pn_transport_free(t1);
+    pn_connection_free(c1);
+
+    pn_transport_unbind(t2);
+    pn_transport_free(t2);
+    pn_connection_free(c2);
+
+    return 0;
+}
+
 
 typedef int (*test_ptr_t)(int argc, char **argv);
 
 test_ptr_t tests[] = {test_free_connection,
                       test_free_session,
                       test_free_link,
+                      test_message_format,
+                      test_shared_payload,
+                      test_abort_delivery,
+                      test_buffer_shrink,
+                      test_idle_shrink,
+                      test_rcv_auto_mode,
                       NULL};
 
 int main(int argc, char **argv)
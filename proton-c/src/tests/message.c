@@ -23,6 +23,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <proton/codec.h>
 #include <proton/error.h>
 #include <proton/message.h>
 
@@ -40,8 +41,318 @@ static void test_overflow_error(void)
   pn_message_free(message);
 }
 
+static void test_compact_encoding(void)
+{
+  pn_data_t *data = pn_data(0);
+  pn_data_put_list(data);
+  pn_data_enter(data);
+  pn_data_put_list(data);
+  pn_data_put_uint(data, 0);
+  pn_data_put_int(data, -1);
+  pn_data_put_long(data, -128);
+  pn_data_exit(data);
+
+  char buf[64];
+  ssize_t size = pn_data_encode(data, buf, sizeof(buf));
+  // list8 [list0, uint0, smallint -1, smalllong -128]
+  const char expected[] = "\xc0\x07\x04\x45\x43\x54\xff\x55\x80";
+  assert(size == sizeof(expected) - 1);
+  assert(!memcmp(buf, expected, size));
+
+  pn_data_t *decoded = pn_data(0);
+  assert(pn_data_decode(decoded, buf, size) == size);
+  pn_data_rewind(decoded);
+  assert(pn_data_next(decoded) && pn_data_type(decoded) == PN_LIST);
+  pn_data_enter(decoded);
+  assert(pn_data_next(decoded) && pn_data_type(decoded) == PN_LIST);
+  assert(pn_data_next(decoded) && pn_data_get_uint(decoded) == 0);
+  assert(pn_data_next(decoded) && pn_data_get_int(decoded) == -1);
+  assert(pn_data_next(decoded) && pn_data_get_long(decoded) == -128);
+
+  pn_data_free(decoded);
+  pn_data_free(data);
+}
+
+static void test_writer(void)
+{
+  pn_data_t *data = pn_data(0);
+  pn_data_fill(data, "DL[S[]@T[ss]{si}]", 0x10, "container", PN_SYMBOL, "a", "b", "key", 1000);
+
+  char expected[256];
+  ssize_t size = pn_data_encode(data, expected, sizeof(expected));
+  assert(size > 0);
+
+  char buf[256];
+  pn_writer_t *writer = pn_writer();
+  pn_writer_bytes(writer, buf, sizeof(buf));
+  pn_writer_put_described(writer);
+  pn_writer_put_ulong(writer, 0x10);
+  pn_writer_begin_list(writer);
+  pn_writer_put_string(writer, pn_bytes(9, "container"));
+  pn_writer_begin_list(writer);
+  pn_writer_end_list(writer);
+  pn_writer_begin_array(writer, false, PN_SYMBOL);
+  pn_writer_put_symbol(writer, pn_bytes(1, "a"));
+  pn_writer_put_symbol(writer, pn_bytes(1, "b"));
+  assert(pn_writer_put_int(writer, 1) == PN_ARG_ERR);
+  pn_writer_end_array(writer);
+  pn_writer_begin_map(writer);
+  pn_writer_put_symbol(writer, pn_bytes(3, "key"));
+  pn_writer_put_int(writer, 1000);
+  assert(pn_writer_end_list(writer) == PN_STATE_ERR);
+  pn_writer_end_map(writer);
+  assert(pn_writer_end_list(writer) == 0);
+  assert(pn_writer_depth(writer) == 0);
+
+  assert(pn_writer_size(writer) == (size_t) size);
+  assert(!memcmp(buf, expected, size));
+
+  pn_writer_free(writer);
+  pn_data_free(data);
+}
+
+static void test_writer_overflow(void)
+{
+  char buf[24];
+  pn_writer_t *writer = pn_writer();
+  pn_writer_bytes(writer, buf, sizeof(buf));
+  assert(pn_writer_begin_list(writer) == 0);
+
+  // a value that does not fit leaves nothing behind
+  assert(pn_writer_put_string(writer, pn_bytes(16, "far too long now")) == PN_OVERFLOW);
+  assert(pn_writer_begin_list(writer) == 0);
+  assert(pn_writer_begin_map(writer) == PN_OVERFLOW);
+  assert(pn_writer_depth(writer) == 2);
+  assert(pn_writer_put_int(writer, 1) == 0);
+  assert(pn_writer_end_list(writer) == 0);
+  assert(pn_writer_end_list(writer) == 0);
+  assert(pn_writer_depth(writer) == 0);
+
+  // list8 [list8 [smallint 1]]
+  const char expected[] = "\xc0\x06\x01\xc0\x03\x01\x54\x01";
+  assert(pn_writer_size(writer) == sizeof(expected) - 1);
+  assert(!memcmp(buf, expected, sizeof(expected) - 1));
+
+  pn_writer_free(writer);
+}
+
+static void test_reader(void)
+{
+  pn_data_t *data = pn_data(0);
+  pn_data_fill(data, "DL[S[I]@T[ss]{si}]", 0x10, "container", 7, PN_SYMBOL, "a", "b", "key", -1000);
+
+  char buf[256];
+  ssize_t size = pn_data_encode(data, buf, sizeof(buf));
+  assert(size > 0);
+
+  pn_reader_t *reader = pn_reader();
+  pn_reader_bytes(reader, buf, size);
+  assert(pn_reader_next(reader) && pn_reader_type(reader) == PN_DESCRIBED);
+  assert(pn_reader_enter(reader));
+  assert(pn_reader_next(reader) && pn_reader_get_ulong(reader) == 0x10);
+  assert(pn_reader_next(reader) && pn_reader_get_list(reader) == 4);
+  assert(pn_reader_enter(reader));
+  assert(pn_reader_next(reader));
+  pn_bytes_t container = pn_reader_get_string(reader);
+  assert(container.size == 9 && !memcmp(container.start, "container", 9));
+  // skip the nested list and array without entering them
+  assert(pn_reader_next(reader) && pn_reader_type(reader) == PN_LIST);
+  assert(pn_reader_next(reader) && pn_reader_get_array(reader) == 2);
+  assert(pn_reader_get_array_type(reader) == PN_SYMBOL);
+  assert(pn_reader_next(reader) && pn_reader_get_map(reader) == 2);
+  assert(pn_reader_enter(reader));
+  assert(pn_reader_next(reader) && pn_reader_type(reader) == PN_SYMBOL);
+  assert(pn_reader_next(reader) && pn_reader_get_int(reader) == -1000);
+  assert(!pn_reader_next(reader));
+  assert(pn_reader_exit(reader));
+  assert(!pn_reader_next(reader));
+  assert(pn_reader_exit(reader));
+  assert(pn_reader_exit(reader));
+  assert(!pn_reader_next(reader));
+  assert(pn_reader_position(reader) == (size_t) size);
+
+  pn_reader_bytes(reader, buf, size - 1);
+  assert(!pn_reader_next(reader));
+  assert(pn_error_code(pn_reader_error(reader)) == PN_UNDERFLOW);
+
+  pn_reader_free(reader);
+  pn_data_free(data);
+}
+
+// enter the only value in bytes, an array, and check it holds count
+// values of the given type
+static void check_array(pn_reader_t *reader, const char *bytes, size_t size,
+                        pn_type_t type, size_t count)
+{
+  pn_reader_bytes(reader, bytes, size);
+  assert(pn_reader_next(reader) && pn_reader_get_array(reader) == count);
+  assert(pn_reader_get_array_type(reader) == type);
+  bool described = pn_reader_is_array_described(reader);
+  assert(pn_reader_enter(reader));
+  if (described) {
+    assert(pn_reader_next(reader) && pn_reader_type(reader) == PN_ULONG);
+  }
+  for (size_t i = 0; i < count; i++) {
+    assert(pn_reader_next(reader) && pn_reader_type(reader) == type);
+  }
+  assert(!pn_reader_next(reader));
+  assert(pn_reader_exit(reader));
+  assert(!pn_reader_next(reader));
+  assert(!pn_error_code(pn_reader_error(reader)));
+}
+
+static void test_reader_arrays(void)
+{
+  pn_reader_t *reader = pn_reader();
+
+  // elements that take no bytes after the shared constructor
+  check_array(reader, "\xe0\x02\x03\x40", 4, PN_NULL, 3);
+  check_array(reader, "\xe0\x02\x03\x45", 4, PN_LIST, 3);
+  check_array(reader, "\xe0\x02\x02\x41", 4, PN_BOOL, 2);
+  check_array(reader, "\xe0\x05\x03\x56\x01\x00\x01", 7, PN_BOOL, 3);
+  // described by ulong 0x10
+  check_array(reader, "\xe0\x05\x02\x00\x53\x10\x40", 7, PN_NULL, 2);
+  check_array(reader, "\xe0\x07\x02\x00\x53\x10\x56\x01\x00", 9, PN_BOOL, 2);
+
+  pn_reader_bytes(reader, "\xe0\x05\x02\x00\x53\x10\x40", 7);
+  assert(pn_reader_next(reader) && pn_reader_is_array_described(reader));
+  assert(pn_reader_enter(reader));
+  assert(pn_reader_next(reader) && pn_reader_get_ulong(reader) == 0x10);
+  assert(pn_reader_next(reader) && pn_reader_type(reader) == PN_NULL);
+
+  // a value whose descriptors are themselves described, very deeply
+  size_t depth = 1 << 20;
+  char *nested = (char *) malloc(2*depth + 1);
+  memset(nested, 0x00, depth);
+  memset(nested + depth, 0x40, depth + 1);
+  pn_reader_bytes(reader, nested, 2*depth + 1);
+  assert(pn_reader_next(reader) && pn_reader_type(reader) == PN_DESCRIBED);
+  assert(pn_reader_position(reader) == 2*depth + 1);
+  assert(!pn_reader_next(reader));
+  pn_reader_bytes(reader, nested, 2*depth);
+  assert(!pn_reader_next(reader));
+  assert(pn_error_code(pn_reader_error(reader)) == PN_UNDERFLOW);
+  free(nested);
+
+  pn_reader_free(reader);
+}
+
+static void test_lookup(void)
+{
+  pn_data_t *data = pn_data(0);
+  char key[32];
+
+  pn_data_put_map(data);
+  pn_data_enter(data);
+  for (int i = 0; i < 100; i++) {
+    sprintf(key, "key-%d", i);
+    pn_data_put_symbol(data, pn_bytes(strlen(key), key));
+    pn_data_put_int(data, i);
+  }
+  pn_data_exit(data);
+
+  for (int i = 99; i >= 0; i--) {
+    sprintf(key, "key-%d", i);
+    pn_data_rewind(data);
+    pn_data_next(data);
+    pn_data_enter(data);
+    assert(pn_data_lookup(data, key));
+    assert(pn_data_get_int(data) == i);
+  }
+
+  pn_data_rewind(data);
+  pn_data_next(data);
+  pn_data_enter(data);
+  assert(!pn_data_lookup(data, "key-1x"));
+  assert(!pn_data_lookup(data, "key"));
+
+  // adding an entry invalidates the index
+  pn_data_put_string(data, pn_bytes(5, "extra"));
+  pn_data_put_int(data, -1);
+  pn_data_rewind(data);
+  pn_data_next(data);
+  pn_data_enter(data);
+  assert(pn_data_lookup(data, "extra"));
+  assert(pn_data_get_int(data) == -1);
+
+  pn_data_free(data);
+}
+
+static void test_copy_on_write(void)
+{
+  pn_data_t *src = pn_data(0);
+  pn_data_t *copy = pn_data(0);
+  pn_data_fill(src, "{sS}", "key", "value");
+  assert(pn_data_copy(copy, src) == 0);
+  assert(pn_data_size(copy) == pn_data_size(src));
+
+  // appending to the copy must not show through to the source
+  pn_data_rewind(copy);
+  pn_data_next(copy);
+  pn_data_put_int(copy, 1);
+  assert(pn_data_size(copy) == pn_data_size(src) + 1);
+
+  // nor may freeing the source invalidate the copy's bytes
+  pn_data_free(src);
+  pn_data_rewind(copy);
+  pn_data_next(copy);
+  pn_data_enter(copy);
+  assert(pn_data_lookup(copy, "key"));
+  pn_bytes_t value = pn_data_get_string(copy);
+  assert(value.size == 5 && !memcmp(value.start, "value", 5));
+
+  pn_data_free(copy);
+}
+
+static void test_batch(void)
+{
+  pn_message_t *msg = pn_message();
+  char big[300];
+  memset(big, 'x', sizeof(big));
+
+  // one small entry takes the vbin8 framing, one large takes vbin32
+  char batch[1024];
+  size_t size = 0;
+  pn_message_set_address(msg, "one");
+  ssize_t n = pn_message_batch_encode(msg, batch, sizeof(batch));
+  assert(n > 0 && (uint8_t) batch[0] == 0xa0 && (uint8_t) batch[1] == n - 2);
+  size += n;
+  pn_message_set_address(msg, "two");
+  pn_data_put_binary(pn_message_body(msg), pn_bytes(sizeof(big), big));
+  n = pn_message_batch_encode(msg, batch + size, sizeof(batch) - size);
+  assert(n > 300 && (uint8_t) batch[size] == 0xb0);
+  size += n;
+  assert(pn_message_batch_encode(msg, batch + size, 16) == PN_OVERFLOW);
+
+  pn_message_t *out = pn_message();
+  const char *names[] = {"one", "two"};
+  size_t offset = 0;
+  for (int i = 0; i < 2; i++) {
+    n = pn_message_batch_decode(out, batch + offset, size - offset);
+    assert(n > 0);
+    assert(!strcmp(pn_message_get_address(out), names[i]));
+    offset += n;
+  }
+  assert(offset == size);
+  assert(pn_message_batch_decode(out, batch + offset, 0) == PN_EOS);
+  assert(pn_message_batch_decode(out, batch, 1) == PN_UNDERFLOW);
+  assert(pn_message_batch_decode(out, batch, batch[1]) == PN_UNDERFLOW);
+  assert(pn_message_batch_decode(out, "\x00", 1) == PN_ARG_ERR);
+
+  pn_message_free(out);
+  pn_message_free(msg);
+}
+
 int main(int argc, char **argv)
 {
   test_overflow_error();
+  test_compact_encoding();
+  test_writer();
+  test_writer_overflow();
+  test_reader();
+  test_reader_arrays();
+  test_lookup();
+  test_copy_on_write();
+  test_batch();
   return 0;
 }
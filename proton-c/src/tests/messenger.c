@@ -0,0 +1,596 @@
+/*
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <proton/engine.h>
+#include <proton/error.h>
+#include <proton/io.h>
+#include <proton/message.h>
+#include <proton/messenger.h>
+#include <proton/sasl.h>
+#include "messenger/messenger.h"
+#include "platform.h"
+
+#define assert(E) ((E) ? 0 : (abort(), 0))
+
+#define ADDR_A "127.0.0.1:56731"
+#define ADDR_B "127.0.0.1:56732"
+#define ADDR_S "127.0.0.1:56733"
+#define PEER_PORT "56734"
+
+static pn_messenger_t *messenger(const char *name)
+{
+  pn_messenger_t *m = pn_messenger(name);
+  pn_messenger_set_blocking(m, false);
+  assert(!pn_messenger_start(m));
+  return m;
+}
+
+static void put(pn_messenger_t *m, const char *address, int body)
+{
+  pn_message_t *msg = pn_message();
+  pn_message_set_address(msg, address);
+  pn_data_put_int(pn_message_body(msg), body);
+  assert(!pn_messenger_put(m, msg));
+  pn_message_free(msg);
+}
+
+// run both messengers until the receiver has count messages waiting
+static void deliver(pn_messenger_t *snd, pn_messenger_t *rcv, int count)
+{
+  for (int i = 0; i < 500 && pn_messenger_incoming(rcv) < count; i++) {
+    pn_messenger_send(snd, -1);
+    pn_messenger_recv(rcv, -1);
+    pn_messenger_work(rcv, 10);
+    pn_messenger_work(snd, 10);
+  }
+  assert(pn_messenger_incoming(rcv) == count);
+}
+
+// get the next message and check it came from sub with the given body
+static void expect(pn_messenger_t *m, pn_subscription_t *sub, int body)
+{
+  pn_message_t *msg = pn_message();
+  assert(!pn_messenger_get(m, msg));
+  assert(pn_messenger_incoming_subscription(m) == sub);
+  pn_data_t *data = pn_message_body(msg);
+  pn_data_rewind(data);
+  assert(pn_data_next(data));
+  assert(pn_data_get_int(data) == body);
+  pn_message_free(msg);
+}
+
+// stop both messengers, running them until they have closed down
+static void stop(pn_messenger_t *snd, pn_messenger_t *rcv)
+{
+  pn_messenger_stop(snd);
+  pn_messenger_stop(rcv);
+  for (int i = 0; i < 500; i++) {
+    if (pn_messenger_stopped(snd) && pn_messenger_stopped(rcv)) break;
+    pn_messenger_work(snd, 10);
+    pn_messenger_work(rcv, 10);
+  }
+  assert(pn_messenger_stopped(snd) && pn_messenger_stopped(rcv));
+  pn_messenger_free(snd);
+  pn_messenger_free(rcv);
+}
+
+static void test_get_order(void)
+{
+  pn_messenger_t *rcv = messenger("test-rcv");
+  pn_subscription_t *a = pn_messenger_subscribe(rcv, "amqp://~" ADDR_A);
+  pn_subscription_t *b = pn_messenger_subscribe(rcv, "amqp://~" ADDR_B);
+  assert(a && b);
+  pn_messenger_t *snd = messenger("test-snd");
+  for (int i = 0; i < 4; i++) put(snd, "amqp://" ADDR_A, i);
+  for (int i = 0; i < 2; i++) put(snd, "amqp://" ADDR_B, 10 + i);
+  deliver(snd, rcv, 6);
+
+  // subscriptions take turns, each in arrival order
+  expect(rcv, a, 0);
+  expect(rcv, b, 10);
+  expect(rcv, a, 1);
+  expect(rcv, b, 11);
+  expect(rcv, a, 2);
+  expect(rcv, a, 3);
+  assert(pn_messenger_get(rcv, NULL) == PN_EOS);
+
+  stop(snd, rcv);
+}
+
+static void test_get_from(void)
+{
+  pn_messenger_t *rcv = messenger("test-rcv");
+  pn_subscription_t *a = pn_messenger_subscribe(rcv, "amqp://~" ADDR_A);
+  pn_subscription_t *b = pn_messenger_subscribe(rcv, "amqp://~" ADDR_B);
+  pn_messenger_t *snd = messenger("test-snd");
+  for (int i = 0; i < 2; i++) put(snd, "amqp://" ADDR_A, i);
+  put(snd, "amqp://" ADDR_B, 10);
+  deliver(snd, rcv, 3);
+
+  pn_message_t *msg = pn_message();
+  assert(pn_messenger_get_from(rcv, NULL, msg) == PN_ARG_ERR);
+  assert(!pn_messenger_get_from(rcv, b, msg));
+  assert(pn_messenger_incoming_subscription(rcv) == b);
+  assert(pn_messenger_get_from(rcv, b, msg) == PN_EOS);
+  assert(pn_messenger_incoming(rcv) == 2);
+  pn_message_free(msg);
+
+  // the other subscription's messages are left as they were
+  expect(rcv, a, 0);
+  expect(rcv, a, 1);
+
+  stop(snd, rcv);
+}
+
+static void test_weights(void)
+{
+  pn_messenger_t *rcv = messenger("test-rcv");
+  pn_subscription_t *a = pn_messenger_subscribe(rcv, "amqp://~" ADDR_A);
+  pn_subscription_t *b = pn_messenger_subscribe(rcv, "amqp://~" ADDR_B);
+  assert(pn_subscription_get_weight(a) == 1);
+  assert(pn_subscription_set_weight(a, 0) == PN_ARG_ERR);
+  assert(!pn_subscription_set_weight(a, 3));
+  assert(pn_subscription_get_weight(a) == 3);
+
+  pn_messenger_t *snd = messenger("test-snd");
+  for (int i = 0; i < 6; i++) put(snd, "amqp://" ADDR_A, i);
+  for (int i = 0; i < 3; i++) put(snd, "amqp://" ADDR_B, 10 + i);
+  deliver(snd, rcv, 9);
+
+  expect(rcv, a, 0);
+  expect(rcv, a, 1);
+  expect(rcv, a, 2);
+  expect(rcv, b, 10);
+  expect(rcv, a, 3);
+  expect(rcv, a, 4);
+  expect(rcv, a, 5);
+  expect(rcv, b, 11);
+  expect(rcv, b, 12);
+
+  stop(snd, rcv);
+}
+
+static void test_unsubscribed_turn(void)
+{
+  pn_messenger_t *rcv = messenger("test-rcv");
+  pn_subscription_t *a = pn_messenger_subscribe(rcv, "amqp://~" ADDR_A);
+  pn_messenger_t *snd = messenger("test-snd");
+  assert(pn_messenger_subscribe(snd, "amqp://~" ADDR_S));
+
+  // connect out to the sender so it can send back over that
+  // connection; what arrives that way belongs to no subscription
+  put(rcv, "amqp://" ADDR_S, -1);
+  deliver(rcv, snd, 1);
+  assert(!pn_messenger_get(snd, NULL));
+
+  for (int i = 0; i < 4; i++) put(snd, "amqp://" ADDR_A, i);
+  for (int i = 0; i < 2; i++) put(snd, "amqp://test-rcv/reply", 10 + i);
+  deliver(snd, rcv, 6);
+
+  // a busy subscription does not starve them
+  expect(rcv, a, 0);
+  expect(rcv, NULL, 10);
+  expect(rcv, a, 1);
+  expect(rcv, NULL, 11);
+  expect(rcv, a, 2);
+  expect(rcv, a, 3);
+
+  stop(snd, rcv);
+}
+
+static void test_unix_sockets(void)
+{
+  char path[64], listen[128], target[128];
+  snprintf(path, sizeof(path), "/tmp/pn-messenger-test-%d.sock", (int) getpid());
+  snprintf(listen, sizeof(listen), "amqp+unix://~%%2Ftmp%%2Fpn-messenger-test-%d.sock",
+           (int) getpid());
+  snprintf(target, sizeof(target), "amqp+unix://%%2Ftmp%%2Fpn-messenger-test-%d.sock/q",
+           (int) getpid());
+
+  pn_messenger_t *rcv = messenger("test-rcv");
+  pn_subscription_t *a = pn_messenger_subscribe(rcv, listen);
+  pn_subscription_t *b = pn_messenger_subscribe(rcv, "amqp+unix://~pn-messenger-test");
+  assert(a && b);
+  assert(!access(path, F_OK));
+
+  // a live listener keeps its socket file
+  pn_messenger_t *other = messenger("test-other");
+  assert(!pn_messenger_subscribe(other, listen));
+  pn_messenger_free(other);
+
+  pn_messenger_t *snd = messenger("test-snd");
+  put(snd, target, 1);
+  put(snd, "amqp+unix://pn-messenger-test/q", 2);
+  deliver(snd, rcv, 2);
+  expect(rcv, a, 1);
+  expect(rcv, b, 2);
+  stop(snd, rcv);
+
+  // but a stale one left behind by a listener that went away is reused
+  other = messenger("test-other");
+  assert(pn_messenger_subscribe(other, listen));
+  pn_messenger_stop(other);
+  pn_messenger_free(other);
+  unlink(path);
+}
+
+static void test_warm(void)
+{
+  pn_messenger_t *rcv = messenger("test-rcv");
+  pn_messenger_set_incoming_window(rcv, 1);
+  pn_subscription_t *a = pn_messenger_subscribe(rcv, "amqp://~" ADDR_A);
+  pn_messenger_t *snd = messenger("test-snd");
+  pn_messenger_set_outgoing_window(snd, 1);
+  assert(!pn_messenger_set_reconnect_backoff(snd, 10000, 10000));
+  assert(!pn_messenger_warm(snd, "amqp://" ADDR_A "/q"));
+  pn_link_t *link = pni_messenger_warm_link(snd, "amqp://" ADDR_A "/q");
+  assert(link);
+
+  // a put to the warm address goes out on the link opened up front
+  put(snd, "amqp://" ADDR_A "/q", 1);
+  deliver(snd, rcv, 1);
+  pn_tracker_t tracker = pn_messenger_outgoing_tracker(snd);
+  assert(pn_delivery_link(pn_messenger_delivery(snd, tracker)) == link);
+  expect(rcv, a, 1);
+
+  // the link is dropped once the peer closes it, and puts go back to
+  // resolving the address
+  tracker = pn_messenger_incoming_tracker(rcv);
+  pn_link_close(pn_delivery_link(pn_messenger_delivery(rcv, tracker)));
+  for (int i = 0; i < 500 && pni_messenger_warm_link(snd, "amqp://" ADDR_A "/q"); i++) {
+    pn_messenger_work(rcv, 10);
+    pn_messenger_work(snd, 10);
+  }
+  assert(!pni_messenger_warm_link(snd, "amqp://" ADDR_A "/q"));
+  put(snd, "amqp://" ADDR_A "/q", 2);
+  deliver(snd, rcv, 1);
+  expect(rcv, a, 2);
+
+  stop(snd, rcv);
+}
+
+static void test_stripe_groups(void)
+{
+  const char *groups[] = {"g0", "g1", "g2", "g3"};
+  pn_messenger_t *rcv = messenger("test-rcv");
+  pn_messenger_set_incoming_window(rcv, 16);
+  pn_subscription_t *a = pn_messenger_subscribe(rcv, "amqp://~" ADDR_A);
+  pn_messenger_t *snd = messenger("test-snd");
+  assert(!pn_messenger_stripe(snd, "amqp://" ADDR_A "/*", 3, PN_STRIPE_ORDERED));
+
+  // the receiver grants no credit until everything has been put
+  pn_message_t *msg = pn_message();
+  for (int i = 0; i < 12; i++) {
+    pn_message_clear(msg);
+    pn_message_set_address(msg, "amqp://" ADDR_A "/q");
+    pn_message_set_group_id(msg, groups[i % 4]);
+    pn_data_put_int(pn_message_body(msg), i);
+    assert(!pn_messenger_put(snd, msg));
+    pn_messenger_work(snd, 0);
+    pn_messenger_work(rcv, 0);
+  }
+  deliver(snd, rcv, 12);
+
+  // each group arrives in order, all of it over one link
+  const char *links[4] = {NULL, NULL, NULL, NULL};
+  int last[4] = {-1, -1, -1, -1};
+  int distinct = 0;
+  for (int i = 0; i < 12; i++) {
+    assert(!pn_messenger_get(rcv, msg));
+    assert(pn_messenger_incoming_subscription(rcv) == a);
+    int g = pn_message_get_group_id(msg)[1] - '0';
+    pn_data_t *body = pn_message_body(msg);
+    pn_data_rewind(body);
+    assert(pn_data_next(body));
+    int n = pn_data_get_int(body);
+    assert(n % 4 == g && n > last[g]);
+    last[g] = n;
+    pn_delivery_t *d = pn_messenger_delivery(rcv, pn_messenger_incoming_tracker(rcv));
+    const char *name = pn_link_name(pn_delivery_link(d));
+    if (!links[g]) {
+      bool seen = false;
+      for (int j = 0; j < 4; j++) seen = seen || (links[j] && !strcmp(links[j], name));
+      if (!seen) distinct++;
+      links[g] = name;
+    }
+    assert(!strcmp(links[g], name));
+  }
+  assert(distinct > 1);
+  pn_message_free(msg);
+
+  stop(snd, rcv);
+}
+
+typedef struct {
+  int calls;
+  pn_tracker_t tracker;
+  pn_status_t status;
+} outcome_t;
+
+static void record(pn_messenger_t *m, pn_tracker_t tracker, pn_status_t status,
+                   void *context)
+{
+  outcome_t *outcome = (outcome_t *) context;
+  if (!outcome->calls++ || status != PN_STATUS_SETTLED) {
+    outcome->tracker = tracker;
+    outcome->status = status;
+  }
+}
+
+static void test_tracker_callbacks(void)
+{
+  pn_messenger_t *rcv = messenger("test-rcv");
+  pn_messenger_set_incoming_window(rcv, 10);
+  assert(pn_messenger_subscribe(rcv, "amqp://~" ADDR_A));
+  pn_messenger_t *snd = messenger("test-snd");
+  pn_messenger_set_outgoing_window(snd, 10);
+  outcome_t all = {0}, one = {0};
+  assert(!pn_messenger_set_tracker_callback(snd, record, &all));
+
+  put(snd, "amqp://" ADDR_A, 0);
+  pn_tracker_t t0 = pn_messenger_outgoing_tracker(snd);
+  pn_message_t *msg = pn_message();
+  pn_message_set_address(msg, "amqp://" ADDR_A);
+  assert(!pn_messenger_put_callback(snd, msg, record, &one));
+  pn_tracker_t t1 = pn_messenger_outgoing_tracker(snd);
+  deliver(snd, rcv, 2);
+  assert(!all.calls && !one.calls);
+
+  assert(!pn_messenger_get(rcv, msg));
+  assert(!pn_messenger_reject(rcv, pn_messenger_incoming_tracker(rcv), 0));
+  assert(!pn_messenger_get(rcv, msg));
+  assert(!pn_messenger_accept(rcv, pn_messenger_incoming_tracker(rcv), 0));
+  pn_message_free(msg);
+  for (int i = 0; i < 500 && !(all.calls && one.calls); i++) {
+    pn_messenger_work(rcv, 10);
+    pn_messenger_work(snd, 10);
+  }
+
+  // the outcomes arrive without polling, each at the callback that
+  // applies to its tracker
+  assert(all.calls && all.tracker == t0 && all.status == PN_STATUS_REJECTED);
+  assert(one.calls && one.tracker == t1 && one.status == PN_STATUS_ACCEPTED);
+
+  stop(snd, rcv);
+}
+
+// run both messengers a while without the receiver granting credit
+static void idle(pn_messenger_t *snd, pn_messenger_t *rcv, int millis)
+{
+  for (int i = 0; i < millis/10; i++) {
+    pn_messenger_work(snd, 10);
+    pn_messenger_work(rcv, 0);
+  }
+}
+
+static void test_outgoing_limit(void)
+{
+  pn_messenger_t *rcv = messenger("test-rcv");
+  assert(pn_messenger_subscribe(rcv, "amqp://~" ADDR_A));
+  pn_messenger_t *snd = messenger("test-snd");
+  assert(!pn_messenger_set_outgoing_limit(snd, 3));
+  assert(pn_messenger_get_outgoing_limit(snd) == 3);
+
+  // messages waiting for credit count against the limit
+  for (int i = 0; i < 3; i++) put(snd, "amqp://" ADDR_A, i);
+  idle(snd, rcv, 50);
+  pn_message_t *msg = pn_message();
+  pn_message_set_address(msg, "amqp://" ADDR_A);
+  assert(pn_messenger_put(snd, msg) == PN_INPROGRESS);
+  assert(pn_messenger_outgoing(snd) == 3);
+
+  // and stop counting once they have been written out
+  deliver(snd, rcv, 3);
+  assert(!pn_messenger_put(snd, msg));
+  deliver(snd, rcv, 4);
+
+  pn_message_free(msg);
+  stop(snd, rcv);
+}
+
+static void test_outgoing_byte_limit(void)
+{
+  pn_messenger_t *rcv = messenger("test-rcv");
+  assert(pn_messenger_subscribe(rcv, "amqp://~" ADDR_A));
+  pn_messenger_t *snd = messenger("test-snd");
+  assert(!pn_messenger_set_outgoing_byte_limit(snd, 1));
+  assert(pn_messenger_get_outgoing_byte_limit(snd) == 1);
+
+  // the byte limit admits one message past it, then waits the same way
+  pn_message_t *msg = pn_message();
+  pn_message_set_address(msg, "amqp://" ADDR_A);
+  assert(!pn_messenger_put(snd, msg));
+  idle(snd, rcv, 50);
+  assert(pn_messenger_put(snd, msg) == PN_INPROGRESS);
+  deliver(snd, rcv, 1);
+  assert(!pn_messenger_put(snd, msg));
+  deliver(snd, rcv, 2);
+
+  pn_message_free(msg);
+  stop(snd, rcv);
+}
+
+static void test_outgoing_limit_released(void)
+{
+  pn_messenger_t *rcv = messenger("test-rcv");
+  assert(pn_messenger_subscribe(rcv, "amqp://~" ADDR_A));
+  pn_messenger_t *snd = messenger("test-snd");
+  pn_messenger_set_outgoing_window(snd, 10);
+  assert(!pn_messenger_set_outgoing_limit(snd, 2));
+  pn_message_t *msg = pn_message();
+  pn_message_set_address(msg, "amqp://" ADDR_A);
+
+  // messages that expire while waiting for credit give up their place
+  pn_message_set_ttl(msg, 50);
+  assert(!pn_messenger_put(snd, msg));
+  assert(!pn_messenger_put(snd, msg));
+  pn_tracker_t expired = pn_messenger_outgoing_tracker(snd);
+  pn_message_set_ttl(msg, 0);
+  assert(pn_messenger_put(snd, msg) == PN_INPROGRESS);
+  idle(snd, rcv, 200);
+  assert(pn_messenger_status(snd, expired) == PN_STATUS_ABORTED);
+  assert(!pn_messenger_put(snd, msg));
+  assert(!pn_messenger_put(snd, msg));
+  pn_tracker_t aborted = pn_messenger_outgoing_tracker(snd);
+  assert(pn_messenger_put(snd, msg) == PN_INPROGRESS);
+
+  // as do those aborted when their connection goes away
+  pn_messenger_stop(rcv);
+  for (int i = 0; i < 100 && !pn_messenger_stopped(rcv); i++) {
+    pn_messenger_work(rcv, 10);
+    pn_messenger_work(snd, 10);
+  }
+  for (int i = 0; i < 100 && pn_messenger_status(snd, aborted) != PN_STATUS_ABORTED; i++) {
+    pn_messenger_work(snd, 10);
+  }
+  assert(pn_messenger_status(snd, aborted) == PN_STATUS_ABORTED);
+  pn_messenger_set_outgoing_window(snd, 0);
+  pn_message_set_address(msg, "amqp://" ADDR_B);
+  assert(!pn_messenger_put(snd, msg));
+
+  pn_message_free(msg);
+  pn_messenger_start(rcv);
+  stop(snd, rcv);
+}
+
+static void test_deadline(void)
+{
+  pn_messenger_t *rcv = messenger("test-rcv");
+  assert(pn_messenger_subscribe(rcv, "amqp://~" ADDR_A));
+  pn_messenger_t *snd = messenger("test-snd");
+  assert(!pn_messenger_deadline(snd));
+  pn_message_t *msg = pn_message();
+  pn_message_set_address(msg, "amqp://" ADDR_A);
+
+  // a message waiting for credit sets a deadline on the wall clock,
+  // whether it carries a ttl or an absolute expiry time
+  pn_message_set_ttl(msg, 3000);
+  assert(!pn_messenger_put(snd, msg));
+  idle(snd, rcv, 50);
+  pn_timestamp_t wall = pn_i_now() + 3000;
+  pn_timestamp_t d = pn_messenger_deadline(snd);
+  assert(d > wall - 200 && d <= wall);
+
+  pn_message_set_ttl(msg, 0);
+  pn_message_set_expiry_time(msg, pn_i_now() + 2000);
+  assert(!pn_messenger_put(snd, msg));
+  idle(snd, rcv, 50);
+  wall = pn_i_now() + 2000;
+  d = pn_messenger_deadline(snd);
+  assert(d > wall - 200 && d <= wall);
+
+  deliver(snd, rcv, 2);
+  pn_message_free(msg);
+  stop(snd, rcv);
+}
+
+// move whatever is waiting between a bare engine peer and its socket
+static void pump(pn_io_t *io, pn_socket_t sock, pn_transport_t *transport)
+{
+  ssize_t capacity = pn_transport_capacity(transport);
+  if (capacity > 0) {
+    ssize_t n = pn_recv(io, sock, pn_transport_tail(transport), capacity);
+    if (n > 0) pn_transport_process(transport, n);
+  }
+  pn_transport_tick(transport, pn_i_monotonic_ms());
+  ssize_t pending = pn_transport_pending(transport);
+  if (pending > 0) {
+    ssize_t n = pn_send(io, sock, pn_transport_head(transport), pending);
+    if (n > 0) pn_transport_pop(transport, n);
+  }
+}
+
+static void test_idle_keepalive(void)
+{
+  pn_io_t *io = pn_io();
+  pn_socket_t lsock = pn_listen(io, "127.0.0.1", PEER_PORT);
+  assert(lsock != PN_INVALID_SOCKET);
+  pn_messenger_t *snd = messenger("test-snd");
+  put(snd, "amqp://127.0.0.1:" PEER_PORT, 0);
+  pn_messenger_work(snd, 0);
+  char name[256];
+  pn_socket_t sock = pn_accept(io, lsock, name, sizeof(name));
+  assert(sock != PN_INVALID_SOCKET);
+
+  // the peer times out after 400ms of silence, advertising half that
+  pn_transport_t *transport = pn_transport();
+  pn_sasl_t *sasl = pn_sasl(transport);
+  pn_sasl_mechanisms(sasl, "ANONYMOUS");
+  pn_sasl_server(sasl);
+  pn_sasl_done(sasl, PN_SASL_OK);
+  pn_transport_set_idle_timeout(transport, 400);
+  pn_connection_t *connection = pn_connection();
+  pn_connection_open(connection);
+  pn_transport_bind(transport, connection);
+  for (int i = 0; i < 100; i++) {
+    pump(io, sock, transport);
+    pn_messenger_work(snd, 10);
+    if (pn_messenger_get_remote_idle_timeout(snd, "amqp://127.0.0.1:" PEER_PORT) == 200) break;
+  }
+  assert(pn_messenger_get_remote_idle_timeout(snd, "amqp://127.0.0.1:" PEER_PORT) == 200);
+
+  // with nothing else to do, the transport's deadline wakes the
+  // messenger in time to keep the connection alive, and each wakeup
+  // sends its heartbeat rather than leaving it for the next
+  uint64_t frames = pn_transport_get_frames_input(transport);
+  for (int i = 0; i < 10; i++) {
+    pn_timestamp_t start = pn_i_monotonic_ms();
+    pn_messenger_work(snd, 2000);
+    assert(pn_i_monotonic_ms() - start < 400);
+    pump(io, sock, transport);
+  }
+  assert(pn_transport_get_frames_input(transport) - frames >= 9);
+  assert(!pn_condition_is_set(pn_transport_condition(transport)));
+
+  pn_close(io, sock);
+  pn_messenger_stop(snd);
+  for (int i = 0; i < 100 && !pn_messenger_stopped(snd); i++) {
+    pn_messenger_work(snd, 10);
+  }
+  assert(pn_messenger_stopped(snd));
+  pn_messenger_free(snd);
+  pn_transport_free(transport);
+  pn_connection_free(connection);
+  pn_close(io, lsock);
+  pn_io_free(io);
+}
+
+int main(int argc, char **argv)
+{
+  test_get_order();
+  test_get_from();
+  test_weights();
+  test_unsubscribed_turn();
+  test_unix_sockets();
+  test_warm();
+  test_stripe_groups();
+  test_tracker_callbacks();
+  test_outgoing_limit();
+  test_outgoing_byte_limit();
+  test_outgoing_limit_released();
+  test_deadline();
+  test_idle_keepalive();
+  return 0;
+}
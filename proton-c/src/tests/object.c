@@ -272,6 +272,10 @@ static void test_list(size_t capacity)
   assert(pn_list_size(list) == 2);
   assert(pn_list_get(list, 0) == (void *) 0);
   assert(pn_list_get(list, 1) == (void *) 3);
+  pn_list_clear(list);
+  assert(pn_list_size(list) == 0);
+  pn_list_clear(list);
+  assert(pn_list_size(list) == 0);
   pn_decref(list);
 }
 
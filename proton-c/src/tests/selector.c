@@ -0,0 +1,215 @@
+/*
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ *
+ */
+
+#include <stdlib.h>
+#include <unistd.h>
+#include <proton/selector.h>
+#include "platform.h"
+#include "selectable.h"
+
+#define assert(E) ((E) ? 0 : (abort(), 0))
+
+static ssize_t capacity;
+static pn_timestamp_t deadline;
+
+static ssize_t test_capacity(pn_selectable_t *sel)
+{
+  return capacity;
+}
+
+static ssize_t test_pending(pn_selectable_t *sel)
+{
+  return 0;
+}
+
+static pn_timestamp_t test_deadline(pn_selectable_t *sel)
+{
+  return deadline;
+}
+
+static void test_finalize(pn_selectable_t *sel) {}
+
+static pn_selectable_t *selectable(int fd)
+{
+  pn_selectable_t *sel = pni_selectable(test_capacity, test_pending, test_deadline,
+                                        NULL, NULL, NULL, test_finalize);
+  pni_selectable_set_fd(sel, fd);
+  return sel;
+}
+
+// the events select reports for sel, or zero if it reports none
+static int readable(pn_selector_t *selector, pn_selectable_t *sel)
+{
+  assert(!pn_selector_select(selector, 0));
+  int events = 0;
+  pn_selectable_t *next;
+  int ev;
+  while ((next = pn_selector_next(selector, &ev))) {
+    assert(next == sel);
+    events = ev;
+  }
+  return events & PN_READABLE;
+}
+
+static void test_add_update_remove(void)
+{
+  int fds[2];
+  assert(!pipe(fds));
+  pn_selector_t *selector = pni_selector();
+  capacity = 1;
+  pn_selectable_t *sel = selectable(fds[0]);
+
+  pn_selector_add(selector, sel);
+  assert(!readable(selector, sel));
+  assert(write(fds[1], "x", 1) == 1);
+  assert(readable(selector, sel));
+
+  // no capacity, no interest in reading
+  capacity = 0;
+  pn_selector_update(selector, sel);
+  assert(!readable(selector, sel));
+  capacity = 1;
+  pn_selector_update(selector, sel);
+  assert(readable(selector, sel));
+
+  pn_selector_remove(selector, sel);
+  assert(!readable(selector, sel));
+  pn_selector_add(selector, sel);
+  assert(readable(selector, sel));
+
+  pn_selector_remove(selector, sel);
+  pn_selectable_free(sel);
+  pn_selector_free(selector);
+  close(fds[0]);
+  close(fds[1]);
+}
+
+static void test_fd_reuse(void)
+{
+  int fds[2];
+  assert(!pipe(fds));
+  pn_selector_t *selector = pni_selector();
+  capacity = 1;
+  pn_selectable_t *sel = selectable(fds[0]);
+  pn_selector_add(selector, sel);
+
+  // reconnecting closes the old socket and usually gets its number
+  // back for the new one, with the same interest as before
+  int old = fds[0];
+  close(fds[0]);
+  close(fds[1]);
+  assert(!pipe(fds));
+  assert(fds[0] == old);
+  pni_selectable_set_fd(sel, fds[0]);
+  pn_selector_update(selector, sel);
+
+  assert(write(fds[1], "x", 1) == 1);
+  assert(readable(selector, sel));
+
+  pn_selector_remove(selector, sel);
+  pn_selectable_free(sel);
+  pn_selector_free(selector);
+  close(fds[0]);
+  close(fds[1]);
+}
+
+static void test_spin(void)
+{
+  int fds[2];
+  assert(!pipe(fds));
+  pn_selector_t *selector = pni_selector();
+  assert(pn_selector_get_spin(selector) == 0);
+  pn_selector_set_spin(selector, -1);
+  assert(pn_selector_get_spin(selector) == 0);
+  pn_selector_set_spin(selector, 1000);
+  assert(pn_selector_get_spin(selector) == 1000);
+  capacity = 1;
+  pn_selectable_t *sel = selectable(fds[0]);
+  pn_selector_add(selector, sel);
+
+  // nothing arrives while spinning, so the wait goes on to block
+  assert(!pn_selector_select(selector, 10));
+  assert(pn_selector_spins(selector) == 0 && pn_selector_blocks(selector) == 1);
+
+  // input that is already there is picked up without blocking
+  assert(write(fds[1], "x", 1) == 1);
+  assert(!pn_selector_select(selector, 10));
+  assert(pn_selector_spins(selector) == 1 && pn_selector_blocks(selector) == 1);
+
+  // a zero timeout never spins or blocks
+  assert(!pn_selector_select(selector, 0));
+  assert(pn_selector_spins(selector) == 1 && pn_selector_blocks(selector) == 1);
+
+  pn_selector_remove(selector, sel);
+  pn_selectable_free(sel);
+  pn_selector_free(selector);
+  close(fds[0]);
+  close(fds[1]);
+}
+
+static void test_deadline_clock(void)
+{
+  int fds[2];
+  assert(!pipe(fds));
+  pn_selector_t *selector = pni_selector();
+  capacity = 0;
+  pn_selectable_t *sel = selectable(fds[0]);
+
+  // deadlines are kept on the monotonic clock and handed out on the
+  // wall clock
+  assert(!pn_selectable_deadline(sel));
+  deadline = pn_i_monotonic_ms() + 1000;
+  assert(pni_selectable_deadline(sel) == deadline);
+  pn_timestamp_t wall = pn_i_now() + 1000;
+  pn_timestamp_t d = pn_selectable_deadline(sel);
+  assert(d > wall - 50 && d < wall + 50);
+
+  // and the selector wakes when the monotonic deadline passes
+  deadline = pn_i_monotonic_ms() + 20;
+  pn_selector_add(selector, sel);
+  pn_timestamp_t start = pn_i_monotonic_ms();
+  assert(!pn_selector_select(selector, 5000));
+  assert(pn_i_monotonic_ms() - start < 1000);
+  int ev = 0;
+  assert(pn_selector_next(selector, &ev) == sel && (ev & PN_EXPIRED));
+
+  deadline = 0;
+  pn_selector_remove(selector, sel);
+  pn_selectable_free(sel);
+  pn_selector_free(selector);
+  close(fds[0]);
+  close(fds[1]);
+}
+
+int main(int argc, char **argv)
+{
+  test_add_update_remove();
+  test_fd_reuse();
+  test_spin();
+  test_deadline_clock();
+  // and again with the portable backend
+  setenv("PN_SELECTOR", "poll", 1);
+  test_add_update_remove();
+  test_fd_reuse();
+  test_spin();
+  test_deadline_clock();
+  return 0;
+}
@@ -0,0 +1,255 @@
+/*
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <proton/engine.h>
+#include <proton/error.h>
+#include <proton/shm.h>
+
+// never remove 'assert()'
+#undef NDEBUG
+#include <assert.h>
+
+// pump both sides until neither moves any bytes
+static int pump(pn_shm_t *a, pn_shm_t *b)
+{
+    int total = 0;
+    ssize_t work;
+    do {
+        ssize_t wa = pn_shm_pump(a);
+        ssize_t wb = pn_shm_pump(b);
+        work = (wa > 0 ? wa : 0) + (wb > 0 ? wb : 0);
+        total += work;
+    } while (work);
+    return total;
+}
+
+static void open_all(pn_connection_t *conn)
+{
+    if (pn_connection_state(conn) & PN_LOCAL_UNINIT)
+        pn_connection_open(conn);
+    pn_session_t *ssn = pn_session_head(conn, PN_LOCAL_UNINIT);
+    while (ssn) {
+        pn_session_open(ssn);
+        ssn = pn_session_next(ssn, PN_LOCAL_UNINIT);
+    }
+    pn_link_t *link = pn_link_head(conn, PN_LOCAL_UNINIT);
+    while (link) {
+        pn_link_open(link);
+        link = pn_link_next(link, PN_LOCAL_UNINIT);
+    }
+}
+
+typedef struct {
+    pn_shm_t *shm[2];
+    pn_connection_t *conn[2];
+    pn_transport_t *transport[2];
+} pair_t;
+
+static bool pair_setup(pair_t *p, size_t capacity)
+{
+    p->shm[0] = pn_shm(capacity);
+    if (!p->shm[0]) return false;
+    int fds[3];
+    pn_shm_fds(p->shm[0], fds);
+    p->shm[1] = pn_shm_attach(fds);
+    assert(p->shm[1]);
+    for (int i = 0; i < 2; i++) {
+        p->conn[i] = pn_connection();
+        p->transport[i] = pn_transport();
+        pn_transport_bind(p->transport[i], p->conn[i]);
+        assert(!pn_shm_bind(p->shm[i], p->transport[i]));
+    }
+    return true;
+}
+
+static void pair_free(pair_t *p)
+{
+    for (int i = 0; i < 2; i++) {
+        if (p->shm[i]) pn_shm_free(p->shm[i]);
+        pn_transport_unbind(p->transport[i]);
+        pn_transport_free(p->transport[i]);
+        pn_connection_free(p->conn[i]);
+    }
+}
+
+int test_shm_open(int argc, char **argv)
+{
+    fprintf(stdout, "test_shm_open\n");
+    pair_t p;
+    if (!pair_setup(&p, 0)) return 0;
+
+    pn_connection_open(p.conn[0]);
+    while (pump(p.shm[0], p.shm[1])) {
+        open_all(p.conn[1]);
+    }
+    assert(pn_connection_state(p.conn[0]) == (PN_LOCAL_ACTIVE | PN_REMOTE_ACTIVE));
+    assert(pn_connection_state(p.conn[1]) == (PN_LOCAL_ACTIVE | PN_REMOTE_ACTIVE));
+
+    pair_free(&p);
+    return 0;
+}
+
+// a delivery many times larger than a ring must wrap around it
+int test_shm_wrap(int argc, char **argv)
+{
+    fprintf(stdout, "test_shm_wrap\n");
+    pair_t p;
+    if (!pair_setup(&p, 4096)) return 0;
+
+    pn_connection_open(p.conn[0]);
+    pn_session_t *ssn = pn_session(p.conn[0]);
+    pn_link_t *tx = pn_sender(ssn, "tx");
+    open_all(p.conn[0]);
+    while (pump(p.shm[0], p.shm[1])) {
+        open_all(p.conn[1]);
+    }
+    pn_link_t *rx = pn_link_head(p.conn[1], PN_LOCAL_ACTIVE | PN_REMOTE_ACTIVE);
+    assert(rx && pn_link_is_receiver(rx));
+    pn_link_flow(rx, 1);
+    pump(p.shm[0], p.shm[1]);
+
+    size_t size = 100000;
+    char *body = (char *) malloc(size);
+    for (size_t i = 0; i < size; i++) body[i] = (char) (i % 251);
+    pn_delivery(tx, pn_dtag("tag", 3));
+    assert(pn_link_send(tx, body, size) == (ssize_t) size);
+    pn_link_advance(tx);
+    pump(p.shm[0], p.shm[1]);
+
+    pn_delivery_t *d = pn_link_current(rx);
+    assert(d && !pn_delivery_partial(d));
+    char *received = (char *) malloc(size);
+    assert(pn_link_recv(rx, received, size) == (ssize_t) size);
+    assert(!memcmp(body, received, size));
+
+    free(body);
+    free(received);
+    pair_free(&p);
+    return 0;
+}
+
+// freeing one side closes the peer's input
+int test_shm_close(int argc, char **argv)
+{
+    fprintf(stdout, "test_shm_close\n");
+    pair_t p;
+    if (!pair_setup(&p, 0)) return 0;
+
+    pn_connection_open(p.conn[0]);
+    while (pump(p.shm[0], p.shm[1])) {
+        open_all(p.conn[1]);
+    }
+
+    pn_shm_free(p.shm[0]);
+    p.shm[0] = NULL;
+    ssize_t n;
+    while ((n = pn_shm_pump(p.shm[1])) > 0);
+    assert(pn_transport_capacity(p.transport[1]) < 0);
+
+    pair_free(&p);
+    return 0;
+}
+
+// the parts of the segment layout a misbehaving peer might scribble on
+#define HEADER_SIZE (448)
+#define CAPACITY_OFFSET (8)
+#define RING_HEAD_OFFSET(ring) (64 + 192*(ring))
+
+static char *map_segment(pn_shm_t *shm, size_t size)
+{
+    int fds[3];
+    pn_shm_fds(shm, fds);
+    void *addr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fds[0], 0);
+    assert(addr != MAP_FAILED);
+    return (char *) addr;
+}
+
+// rings are indexed by masking, so only power of two capacities work
+int test_shm_bad_capacity(int argc, char **argv)
+{
+    fprintf(stdout, "test_shm_bad_capacity\n");
+    pn_shm_t *shm = pn_shm(4096);
+    if (!shm) return 0;
+    int fds[3];
+    pn_shm_fds(shm, fds);
+
+    uint64_t capacity = 6144;
+    size_t size = HEADER_SIZE + 2*capacity;
+    assert(!ftruncate(fds[0], size));
+    char *segment = map_segment(shm, size);
+    memcpy(segment + CAPACITY_OFFSET, &capacity, sizeof(capacity));
+    assert(!pn_shm_attach(fds));
+
+    capacity = 4096;
+    memcpy(segment + CAPACITY_OFFSET, &capacity, sizeof(capacity));
+    assert(!pn_shm_attach(fds));
+
+    munmap(segment, size);
+    pn_shm_free(shm);
+    return 0;
+}
+
+// counters further apart than a ring holds are refused before copying
+int test_shm_corrupt(int argc, char **argv)
+{
+    fprintf(stdout, "test_shm_corrupt\n");
+    pair_t p;
+    if (!pair_setup(&p, 4096)) return 0;
+
+    size_t size = HEADER_SIZE + 2*4096;
+    char *segment = map_segment(p.shm[0], size);
+    uint64_t head = 3*4096;
+    // what the creating side reads, then what the attaching side writes
+    memcpy(segment + RING_HEAD_OFFSET(1), &head, sizeof(head));
+    assert(pn_shm_pump(p.shm[0]) == PN_STATE_ERR);
+    memcpy(segment + RING_HEAD_OFFSET(1), &head, sizeof(head));
+    pn_connection_open(p.conn[1]);
+    assert(pn_shm_pump(p.shm[1]) == PN_STATE_ERR);
+
+    munmap(segment, size);
+    pair_free(&p);
+    return 0;
+}
+
+typedef int (*test_ptr_t)(int argc, char **argv);
+
+test_ptr_t tests[] = {test_shm_open,
+                      test_shm_wrap,
+                      test_shm_close,
+                      test_shm_bad_capacity,
+                      test_shm_corrupt,
+                      NULL};
+
+int main(int argc, char **argv)
+{
+    test_ptr_t *test = tests;
+    while (*test) {
+        int rc = (*test++)(argc, argv);
+        if (rc)
+            return rc;
+    }
+    return 0;
+}
@@ -0,0 +1,104 @@
+/*
+ *
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ *
+ */
+
+
+#include <signal.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <proton/messenger.h>
+#include "messenger/store.h"
+
+#define assert(E) ((E) ? 0 : (abort(), 0))
+
+static pni_store_t *tracked_store(int count, pni_entry_t **entries)
+{
+  pni_store_t *store = pni_store();
+  pni_store_set_window(store, count);
+  for (int i = 0; i < count; i++) {
+    pni_entry_t *entry = pni_store_put(store, "queue");
+    assert(pni_entry_track(entry) == (pn_sequence_t) i);
+    pni_entry_free(entry);
+    if (entries) entries[i] = entry;
+  }
+  return store;
+}
+
+static void test_cumulative(void)
+{
+  pni_entry_t *entries[8];
+  pni_store_t *store = tracked_store(8, entries);
+
+  // settles everything up to and including the id, and nothing after
+  assert(!pni_store_update(store, 2, PN_STATUS_ACCEPTED, PN_CUMULATIVE, true, false));
+  for (int i = 0; i < 3; i++) assert(!pni_store_entry(store, i));
+  assert(pni_store_entry(store, 3) == entries[3]);
+
+  assert(!pni_store_update(store, 5, PN_STATUS_ACCEPTED, 0, true, false));
+  assert(!pni_store_entry(store, 5));
+  assert(!pni_store_update(store, 6, PN_STATUS_ACCEPTED, PN_CUMULATIVE, true, false));
+  assert(!pni_store_entry(store, 3) && !pni_store_entry(store, 6));
+  assert(pni_store_entry(store, 7) == entries[7]);
+
+  pni_store_free(store);
+}
+
+static void test_window(void)
+{
+  pni_store_t *store = tracked_store(4, NULL);
+  pni_entry_t *entry = pni_store_put(store, "queue");
+  assert(pni_entry_track(entry) == 4);
+  pni_entry_free(entry);
+
+  // only the most recent window's worth of entries are kept
+  assert(!pni_store_entry(store, 0));
+  for (int i = 1; i < 5; i++) assert(pni_store_entry(store, i));
+  pni_store_free(store);
+}
+
+static void test_cumulative_cost(void)
+{
+  // one early entry stays unsettled while all the later ones are
+  // settled one at a time, so the window stays wide open
+  int count = 100000;
+  pni_store_t *store = tracked_store(count, NULL);
+  for (int i = 1; i < count; i++) {
+    assert(!pni_store_update(store, i, PN_STATUS_ACCEPTED, 0, true, false));
+  }
+
+  // cumulative updates only visit the entries still tracked, rather
+  // than every id back to the oldest one
+  alarm(10);
+  for (int i = 0; i < count; i++) {
+    assert(!pni_store_update(store, count - 1, PN_STATUS_ACCEPTED, PN_CUMULATIVE,
+                             false, false));
+  }
+  alarm(0);
+  assert(pni_store_entry(store, 0));
+  pni_store_free(store);
+}
+
+int main(int argc, char **argv)
+{
+  test_cumulative();
+  test_window();
+  test_cumulative_cost();
+  return 0;
+}
@@ -98,6 +98,37 @@ static ssize_t pn_output_write_amqp_header(pn_io_layer_t *io_layer, char *bytes,
 static ssize_t pn_output_write_amqp(pn_io_layer_t *io_layer, char *bytes, size_t available);
 static pn_timestamp_t pn_tick_amqp(pn_io_layer_t *io_layer, pn_timestamp_t now);
 
+#define PN_TRANSPORT_INITIAL_BUFFER_SIZE \
+  (PN_DEFAULT_MAX_FRAME_SIZE ? PN_DEFAULT_MAX_FRAME_SIZE : 16 * 1024)
+
+static void pni_resize_buffer(char **buf, size_t *size, size_t target)
+{
+  if (target < *size) {
+    char *newbuf = (char *) realloc(*buf, target);
+    if (newbuf) {
+      *buf = newbuf;
+      *size = target;
+    }
+  }
+}
+
+// shrink a transport buffer that has just emptied if recent traffic has
+// used only a small part of it
+static void pni_trim_buffer(char **buf, size_t *size, pni_usage_t *usage)
+{
+  pni_resize_buffer(buf, size, pni_usage_drained(usage, *size, PN_TRANSPORT_INITIAL_BUFFER_SIZE));
+}
+
+// shrink a transport buffer that has sat unused since a burst, returns
+// when to look again
+static pn_timestamp_t pni_idle_buffer(char **buf, size_t *size, size_t pending,
+                                      pni_usage_t *usage, pn_timestamp_t now)
+{
+  if (pending) pni_usage_fill(usage, pending);
+  pni_resize_buffer(buf, size, pni_usage_idle(usage, *size, PN_TRANSPORT_INITIAL_BUFFER_SIZE, now));
+  return pni_usage_deadline(usage);
+}
+
 static void pni_default_tracer(pn_transport_t *transport, const char *message)
 {
   fprintf(stderr, "[%p]:%s\n", (void *) transport, message);
@@ -108,9 +139,11 @@ static void pn_transport_initialize(void *object)
   pn_transport_t *transport = (pn_transport_t *)object;
   transport->freed = false;
   transport->output_buf = NULL;
-  transport->output_size = PN_DEFAULT_MAX_FRAME_SIZE ? PN_DEFAULT_MAX_FRAME_SIZE : 16 * 1024;
+  transport->output_size = PN_TRANSPORT_INITIAL_BUFFER_SIZE;
+  memset(&transport->output_usage, 0, sizeof(pni_usage_t));
   transport->input_buf = NULL;
-  transport->input_size =  PN_DEFAULT_MAX_FRAME_SIZE ? PN_DEFAULT_MAX_FRAME_SIZE : 16 * 1024;
+  transport->input_size = PN_TRANSPORT_INITIAL_BUFFER_SIZE;
+  memset(&transport->input_usage, 0, sizeof(pni_usage_t));
   transport->tracer = pni_default_tracer;
   transport->header_count = 0;
   transport->sasl = NULL;
@@ -762,6 +795,7 @@ int pn_do_attach(pn_dispatcher_t *disp)
 }
 
 int pn_post_flow(pn_transport_t *transport, pn_session_t *ssn, pn_link_t *link);
+int pn_post_disp(pn_transport_t *transport, pn_delivery_t *delivery);
 
 // free the delivery
 static void pn_full_settle(pn_delivery_map_t *db, pn_delivery_t *delivery)
@@ -771,6 +805,38 @@ static void pn_full_settle(pn_delivery_map_t *db, pn_delivery_t *delivery)
   pn_real_settle(delivery);
 }
 
+// apply a receiving link's auto mode to a delivery that has fully arrived
+static int pni_auto_dispose(pn_transport_t *transport, pn_delivery_t *delivery)
+{
+  pn_link_t *link = delivery->link;
+  pn_session_t *ssn = link->session;
+  if (delivery->local.settled) return 0;
+
+  switch (link->rcv_auto_mode) {
+  case PN_RCV_AUTO_ACCEPT:
+    delivery->local.type = PN_ACCEPTED;
+    break;
+  case PN_RCV_AUTO_SETTLE:
+    delivery->local.settled = true;
+    link->unsettled_count--;
+    break;
+  default:
+    return 0;
+  }
+
+  if ((int16_t) ssn->state.local_channel >= 0 && !delivery->remote.settled) {
+    int err = pn_post_disp(transport, delivery);
+    if (err) return err;
+  }
+
+  if (delivery->local.settled) {
+    // nothing more will be said about this delivery, so forget its id
+    // now; the delivery itself is recycled when the link advances past it
+    pn_delivery_map_del(&ssn->state.incoming, delivery);
+  }
+  return 0;
+}
+
 int pn_do_transfer(pn_dispatcher_t *disp)
 {
   // XXX: multi transfer
@@ -779,10 +845,12 @@ int pn_do_transfer(pn_dispatcher_t *disp)
   pn_bytes_t tag;
   bool id_present;
   pn_sequence_t id;
+  bool format_present;
+  uint32_t format;
   bool settled;
   bool more;
-  int err = pn_scan_args(disp, "D.[I?Iz.oo]", &handle, &id_present, &id, &tag,
-                         &settled, &more);
+  int err = pn_scan_args(disp, "D.[I?Iz?Ioo]", &handle, &id_present, &id, &tag,
+                         &format_present, &format, &settled, &more);
   if (err) return err;
   pn_session_t *ssn = pn_channel_state(transport, disp->channel);
 
@@ -811,6 +879,8 @@ int pn_do_transfer(pn_dispatcher_t *disp)
                          state->id, id);
     }
 
+    if (format_present) delivery->format = format;
+
     link->state.delivery_count++;
     link->state.link_credit--;
     link->queued++;
@@ -827,6 +897,11 @@ int pn_do_transfer(pn_dispatcher_t *disp)
   ssn->incoming_bytes += disp->size;
   delivery->done = !more;
 
+  if (delivery->done && link->rcv_auto_mode) {
+    int err = pni_auto_dispose(transport, delivery);
+    if (err) return err;
+  }
+
   ssn->state.incoming_transfer_count++;
   ssn->state.incoming_window--;
 
@@ -1096,6 +1171,8 @@ static ssize_t transport_consume(pn_transport_t *transport)
 
   if (transport->input_pending && consumed) {
     memmove( transport->input_buf,  &transport->input_buf[consumed], transport->input_pending );
+  } else if (!transport->input_pending) {
+    pni_trim_buffer(&transport->input_buf, &transport->input_size, &transport->input_usage);
   }
 
   return consumed;
@@ -1511,20 +1588,20 @@ int pn_process_tpwork_sender(pn_transport_t *transport, pn_delivery_t *delivery,
   bool xfr_posted = false;
   if ((int16_t) ssn_state->local_channel >= 0 && (int32_t) link_state->local_handle >= 0) {
     pn_delivery_state_t *state = &delivery->state;
-    if (!state->sent && (delivery->done || pn_buffer_size(delivery->bytes) > 0) &&
+    if (!state->sent && (delivery->done || pn_delivery_pending(delivery) > 0) &&
         ssn_state->remote_incoming_window > 0 && link_state->link_credit > 0) {
       if (!state->init) {
         state = pn_delivery_map_push(&ssn_state->outgoing, delivery);
       }
 
-      pn_bytes_t bytes = pn_buffer_bytes(delivery->bytes);
+      pn_bytes_t bytes = pni_delivery_bytes(delivery);
       pn_set_payload(transport->disp, bytes.start, bytes.size);
       pn_bytes_t tag = pn_buffer_bytes(delivery->tag);
       int count = pn_post_transfer_frame(transport->disp,
                                          ssn_state->local_channel,
                                          link_state->local_handle,
                                          state->id, &tag,
-                                         0, // message-format
+                                         delivery->format,
                                          delivery->local.settled,
                                          !delivery->done,
                                          ssn_state->remote_incoming_window);
@@ -1534,9 +1611,10 @@ int pn_process_tpwork_sender(pn_transport_t *transport, pn_delivery_t *delivery,
       ssn_state->remote_incoming_window -= count;
 
       int sent = bytes.size - transport->disp->output_size;
-      pn_buffer_trim(delivery->bytes, sent, 0);
+      pni_delivery_consume(delivery, sent);
       link->session->outgoing_bytes -= sent;
-      if (!pn_buffer_size(delivery->bytes) && delivery->done) {
+      link->outgoing_bytes -= sent;
+      if (!pn_delivery_pending(delivery) && delivery->done) {
         state->sent = true;
         link_state->delivery_count++;
         link_state->link_credit--;
@@ -1911,6 +1989,7 @@ static ssize_t transport_produce(pn_transport_t *transport)
     if (n > 0) {
       space -= n;
       transport->output_pending += n;
+      pni_usage_fill(&transport->output_usage, transport->output_pending);
     } else if (n == 0) {
       break;
     } else {
@@ -2054,7 +2133,16 @@ pn_millis_t pn_transport_get_remote_idle_timeout(pn_transport_t *transport)
 pn_timestamp_t pn_transport_tick(pn_transport_t *transport, pn_timestamp_t now)
 {
   pn_io_layer_t *io_layer = transport->io_layers;
-  return io_layer->process_tick( io_layer, now );
+  pn_timestamp_t deadline = io_layer->process_tick( io_layer, now );
+
+  // ask to be ticked again while any buffer is larger than it needs to be
+  deadline = pn_timestamp_min(deadline,
+                              pni_idle_buffer(&transport->input_buf, &transport->input_size,
+                                              transport->input_pending, &transport->input_usage, now));
+  deadline = pn_timestamp_min(deadline,
+                              pni_idle_buffer(&transport->output_buf, &transport->output_size,
+                                              transport->output_pending, &transport->output_usage, now));
+  return pn_timestamp_min(deadline, pn_dispatcher_tick(transport->disp, now));
 }
 
 uint64_t pn_transport_get_frames_output(const pn_transport_t *transport)
@@ -2166,6 +2254,7 @@ int pn_transport_process(pn_transport_t *transport, size_t size)
   size = pn_min( size, (transport->input_size - transport->input_pending) );
   transport->input_pending += size;
   transport->bytes_input += size;
+  pni_usage_fill(&transport->input_usage, transport->input_pending);
 
   ssize_t n = transport_consume( transport );
   if (n == PN_EOS) {
@@ -2229,6 +2318,8 @@ void pn_transport_pop(pn_transport_t *transport, size_t size)
     if (transport->output_pending) {
       memmove( transport->output_buf,  &transport->output_buf[size],
                transport->output_pending );
+    } else {
+      pni_trim_buffer(&transport->output_buf, &transport->output_size, &transport->output_usage);
     }
 
     if (!transport->output_pending && pn_transport_pending(transport) < 0) {
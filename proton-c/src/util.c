@@ -275,3 +275,59 @@ pn_timestamp_t pn_timestamp_min( pn_timestamp_t a, pn_timestamp_t b )
   return b;
 }
 
+
+void pni_usage_fill(pni_usage_t *usage, size_t fill)
+{
+  if (fill > usage->peak) usage->peak = fill;
+  usage->used = true;
+}
+
+// number of lightly used drains before a buffer is halved
+#define PNI_QUIET_DRAINS (64)
+
+// called when a buffer empties, returns the size it should now have
+size_t pni_usage_drained(pni_usage_t *usage, size_t size, size_t floor)
+{
+  size_t target = size;
+  if (size > floor && usage->peak <= size/4) {
+    if (++usage->quiet >= PNI_QUIET_DRAINS) {
+      target = pn_max(floor, size/2);
+      usage->quiet = 0;
+    }
+  } else {
+    usage->quiet = 0;
+  }
+  usage->peak = 0;
+  return target;
+}
+
+// milliseconds a grown buffer may sit unused before it is given back
+#define PNI_IDLE_MILLIS (2000)
+
+// called from a tick, returns the size the buffer should now have. A
+// connection that goes quiet after a burst drains too rarely for
+// pni_usage_drained to shrink its buffers, so time does it instead.
+size_t pni_usage_idle(pni_usage_t *usage, size_t size, size_t floor, pn_timestamp_t now)
+{
+  if (size <= floor) {
+    usage->active = 0;
+    usage->used = false;
+    return size;
+  }
+  if (usage->used || !usage->active) {
+    usage->active = now;
+    usage->used = false;
+    return size;
+  }
+  if (now - usage->active < PNI_IDLE_MILLIS) {
+    return size;
+  }
+  memset(usage, 0, sizeof(pni_usage_t));
+  return floor;
+}
+
+// when pni_usage_idle next needs calling, or zero if never
+pn_timestamp_t pni_usage_deadline(pni_usage_t *usage)
+{
+  return usage->active ? usage->active + PNI_IDLE_MILLIS : 0;
+}
@@ -34,6 +34,7 @@
 #include <proton/object.h>
 
 PN_EXTERN void pni_parse_url(char *url, char **scheme, char **user, char **pass, char **host, char **port, char **path);
+void pni_urldecode(const char *src, char *dst);
 void pni_fatal(const char *fmt, ...);
 void pni_vfatal(const char *fmt, va_list ap);
 PN_EXTERN ssize_t pn_quote_data(char *dst, size_t capacity, const char *src, size_t size);
@@ -45,6 +46,19 @@ bool pni_eq_n_nocase(const char *a, const char *b, int len);
 bool pn_env_bool(const char *name);
 pn_timestamp_t pn_timestamp_min(pn_timestamp_t a, pn_timestamp_t b);
 
+// recent fill levels of a growable buffer, used to shrink it once idle
+typedef struct {
+  size_t peak;            // largest fill since the buffer last drained
+  unsigned quiet;         // consecutive drains that used under a quarter of it
+  pn_timestamp_t active;  // tick at which it was last seen in use, 0 if none
+  bool used;              // filled since the last tick
+} pni_usage_t;
+
+void pni_usage_fill(pni_usage_t *usage, size_t fill);
+size_t pni_usage_drained(pni_usage_t *usage, size_t size, size_t floor);
+size_t pni_usage_idle(pni_usage_t *usage, size_t size, size_t floor, pn_timestamp_t now);
+pn_timestamp_t pni_usage_deadline(pni_usage_t *usage);
+
 #define DIE_IFR(EXPR, STRERR)                                           \
   do {                                                                  \
     int __code__ = (EXPR);                                              \
@@ -626,7 +626,7 @@ void pn_connector_process(pn_connector_t *c)
     ///
     /// Event wakeup
     ///
-    c->wakeup = pn_connector_tick(c, pn_i_now());
+    c->wakeup = pn_connector_tick(c, pn_i_monotonic_ms());
 
     ///
     /// Socket write
@@ -727,6 +727,31 @@ void pn_driver_trace(pn_driver_t *d, pn_trace_t trace)
   d->trace = trace;
 }
 
+void pn_driver_set_spin(pn_driver_t *d, int usecs)
+{
+  pn_selector_set_spin(d->selector, usecs);
+}
+
+int pn_driver_get_spin(pn_driver_t *d)
+{
+  return pn_selector_get_spin(d->selector);
+}
+
+void pn_driver_set_busy_poll(pn_driver_t *d, int usecs)
+{
+  pn_selector_set_busy_poll(d->selector, usecs);
+}
+
+uint64_t pn_driver_spins(pn_driver_t *d)
+{
+  return pn_selector_spins(d->selector);
+}
+
+uint64_t pn_driver_blocks(pn_driver_t *d)
+{
+  return pn_selector_blocks(d->selector);
+}
+
 void pn_driver_free(pn_driver_t *d)
 {
   if (!d) return;
@@ -901,7 +901,7 @@ static void zombie_list_add(iocpdesc_t *iocpd)
     return;
   }
   // Allow 2 seconds for graceful shutdown before releasing socket resource.
-  iocpd->reap_time = pn_i_now() + 2000;
+  iocpd->reap_time = pn_i_monotonic_ms() + 2000;
   pn_list_add(iocpd->iocp->zombie_list, iocpd);
 }
 
@@ -971,7 +971,7 @@ static void drain_zombie_completions(iocp_t *iocp)
     if (grace > 0 && grace < 60000)
       shutdown_grace = (unsigned) grace;
   }
-  pn_timestamp_t now = pn_i_now();
+  pn_timestamp_t now = pn_i_monotonic_ms();
   pn_timestamp_t deadline = now + shutdown_grace;
 
   while (pn_list_size(iocp->zombie_list)) {
@@ -982,7 +982,7 @@ static void drain_zombie_completions(iocp_t *iocp)
       iocp_log("unexpected IOCP failure on Proton IO shutdown %d\n", GetLastError());
       break;
     }
-    now = pn_i_now();
+    now = pn_i_monotonic_ms();
   }
   if (now >= deadline && pn_list_size(iocp->zombie_list) && iocp->iocp_trace)
     // Should only happen if really slow TCP handshakes, i.e. total network failure
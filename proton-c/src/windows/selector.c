@@ -57,6 +57,8 @@ struct pn_selector_t {
   iocpdesc_t *triggered_list_tail;
   iocpdesc_t *deadlines_head;
   iocpdesc_t *deadlines_tail;
+  uint64_t blocks;
+  int spin;
 };
 
 void pn_selector_initialize(void *obj)
@@ -76,6 +78,8 @@ void pn_selector_initialize(void *obj)
   selector->triggered_list_tail = NULL;
   selector->deadlines_head = NULL;
   selector->deadlines_tail = NULL;
+  selector->blocks = 0;
+  selector->spin = 0;
 }
 
 void pn_selector_finalize(void *obj)
@@ -149,7 +153,7 @@ void pn_selector_update(pn_selector_t *selector, pn_selectable_t *selectable)
 {
   int idx = pni_selectable_get_index(selectable);
   assert(idx >= 0);
-  selector->deadlines[idx] = pn_selectable_deadline(selectable);
+  selector->deadlines[idx] = pni_selectable_deadline(selectable);
 
   pn_socket_t sock = pn_selectable_fd(selectable);
   iocpdesc_t *iocpd = (iocpdesc_t *) pn_list_get(selector->iocp_descriptors, idx);
@@ -203,7 +207,7 @@ int pn_selector_select(pn_selector_t *selector, int timeout)
   assert(selector);
   pn_error_clear(selector->error);
   pn_timestamp_t deadline = 0;
-  pn_timestamp_t now = pn_i_now();
+  pn_timestamp_t now = pn_i_monotonic_ms();
 
   if (timeout) {
     if (selector->deadlines_head)
@@ -220,6 +224,7 @@ int pn_selector_select(pn_selector_t *selector, int timeout)
       timeout = delta;
   }	
   deadline = (timeout >= 0) ? now + timeout : 0;
+  if (timeout && selector->spin) selector->blocks++;
 
   // Process all currently available completions, even if matched events available
   pni_iocp_drain_completions(selector->iocp);
@@ -240,7 +245,7 @@ int pn_selector_select(pn_selector_t *selector, int timeout)
     if (rv < 0)
       return pn_error_code(selector->error);
 
-    now = pn_i_now();
+    now = pn_i_monotonic_ms();
     if (zd && zd <= now) {
       pni_zombie_check(selector->iocp, now);
     }
@@ -269,6 +274,37 @@ pn_selectable_t *pn_selector_next(pn_selector_t *selector, int *events)
   return NULL;
 }
 
+// Spinning is not implemented on top of IOCP; the spin period is
+// recorded so that it can be read back, and every wait blocks.
+void pn_selector_set_spin(pn_selector_t *selector, int usecs)
+{
+  assert(selector);
+  selector->spin = usecs > 0 ? usecs : 0;
+}
+
+int pn_selector_get_spin(pn_selector_t *selector)
+{
+  assert(selector);
+  return selector->spin;
+}
+
+void pn_selector_set_busy_poll(pn_selector_t *selector, int usecs)
+{
+  assert(selector);
+}
+
+uint64_t pn_selector_spins(pn_selector_t *selector)
+{
+  assert(selector);
+  return 0;
+}
+
+uint64_t pn_selector_blocks(pn_selector_t *selector)
+{
+  assert(selector);
+  return selector->blocks;
+}
+
 void pn_selector_free(pn_selector_t *selector)
 {
   assert(selector);